@@ -5,6 +5,9 @@
 #include "DrawDebugHelpers.h"
 #include "Components/InstancedStaticMeshComponent.h"
 #include "Engine/StaticMesh.h"
+#include "Async/ParallelFor.h"
+#include "TerrainNoiseCache.h"
+#include "TerrainRandom.h"
 
 // Sets default values
 APerlinMapGenerator::APerlinMapGenerator()
@@ -55,66 +58,101 @@ void APerlinMapGenerator::Tick(float DeltaTime)
 
 void APerlinMapGenerator::GenerateMap()
 {
-    FRandomStream RandStream(Seed);
     FVector Origin = GetActorLocation();
 
     const float TileSize = 100.0f;
     const float WaterHeight = 0.3f;
 
-    for (int32 X = 0; X < MapWidth; ++X)
+    // O rudo vem do cache de tiles: mudar s meshes, materiais ou altura no
+    // recalcula nada. As derivadas analticas do o declive de cada bloco.
+    TArray<float> NoiseMap;
+    TArray<float> NoiseDX;
+    TArray<float> NoiseDY;
+    NoiseMap.SetNumUninitialized(MapWidth * MapHeight);
+    NoiseDX.SetNumUninitialized(MapWidth * MapHeight);
+    NoiseDY.SetNumUninitialized(MapWidth * MapHeight);
+    FTerrainNoiseTileCache::Get().SampleGrid(GetNoiseSettings(), 0, 0, MapWidth, MapHeight, NoiseMap.GetData(), NoiseDX.GetData(), NoiseDY.GetData());
+
+    // Declive (altura por unidade horizontal) acima do qual no nascem rvores
+    const float SlopeScale = HeightMultiplier / TileSize;
+    const float MaxTreeSlope = MaxTreeSlopeAngle >= 90.0f ? MAX_flt : FMath::Tan(FMath::DegreesToRadians(MaxTreeSlopeAngle));
+
+    // Instncias de cada coluna X. Os sorteios so por clula (FTerrainRandom),
+    // ento as colunas rodam em paralelo e o resultado no depende da ordem.
+    struct FColumnInstances
     {
+        TArray<FTransform> Terrain;
+        TArray<FTransform> Water;
+        TArray<FTransform> Trees;
+    };
+
+    TArray<FColumnInstances> Columns;
+    Columns.SetNum(MapWidth);
+
+    ParallelFor(MapWidth, [&](int32 X)
+    {
+        FColumnInstances& Column = Columns[X];
+        Column.Terrain.Reserve(MapHeight);
+
         for (int32 Y = 0; Y < MapHeight; ++Y)
         {
-            float NoiseValue = GeneratePerlinNoise((float)X, (float)Y, RandStream); // [0,1]
+            const int32 Index = Y * MapWidth + X;
+            float NoiseValue = NoiseMap[Index]; // [0,1]
             float Height = NoiseValue * HeightMultiplier;
 
             FVector TileLocation = Origin + FVector(X * TileSize, Y * TileSize, Height * 0.5f);
             FVector TileScale(1.0f, 1.0f, Height / TileSize);
 
             // Instancia o bloco de terreno
-            TerrainISM->AddInstance(FTransform(FRotator::ZeroRotator, TileLocation, TileScale));
+            Column.Terrain.Add(FTransform(FRotator::ZeroRotator, TileLocation, TileScale));
 
             // gua
             if (NoiseValue < WaterHeight)
             {
                 FVector WaterLocation = Origin + FVector(X * TileSize, Y * TileSize, WaterHeight * HeightMultiplier);
-                WaterISM->AddInstance(FTransform(FRotator::ZeroRotator, WaterLocation, FVector(1, 1, 0.05f)));
+                Column.Water.Add(FTransform(FRotator::ZeroRotator, WaterLocation, FVector(1, 1, 0.05f)));
             }
             // Vegetao (ex: floresta)
             else if (NoiseValue >= 0.4f && NoiseValue < 0.6f)
             {
-                if (RandStream.FRand() < 0.2f) // 20% chance de ter rvore
+                const float Slope = FVector2f(NoiseDX[Index], NoiseDY[Index]).Size() * SlopeScale;
+
+                if (Slope <= MaxTreeSlope &&
+                    FTerrainRandom::FRand(Seed, X, Y, ETerrainRandomPurpose::TreePlacement) < 0.2f) // 20% chance de ter rvore
                 {
                     FVector TreeLocation = Origin + FVector(X * TileSize, Y * TileSize, Height + 50.0f);
-                    TreeISM->AddInstance(FTransform(FRotator::ZeroRotator, TreeLocation, FVector(1.0f)));
+                    Column.Trees.Add(FTransform(FRotator::ZeroRotator, TreeLocation, FVector(1.0f)));
                 }
             }
         }
-    }
-}
+    });
 
+    // Junta as colunas na mesma ordem do lao serial (X externo, Y interno)
+    TArray<FTransform> TerrainTransforms;
+    TArray<FTransform> WaterTransforms;
+    TArray<FTransform> TreeTransforms;
+    TerrainTransforms.Reserve(MapWidth * MapHeight);
 
-float APerlinMapGenerator::GeneratePerlinNoise(float X, float Y, FRandomStream& RandStream)
-{
-    float Total = 0.0f;
-    float Frequency = 6.5f;
-    float Amplitude = 100.0f;
-    float MaxValue = 0.0f;
-
-    for (int32 i = 0; i < Octaves; ++i)
+    for (const FColumnInstances& Column : Columns)
     {
-        float SampleX = (X / NoiseScale) * Frequency;
-        float SampleY = (Y / NoiseScale) * Frequency;
-
-        // Rudo Perlin normalizado [0,1]
-        float Noise = FMath::PerlinNoise2D(FVector2D(SampleX, SampleY)) * 0.5f + 0.5f;
+        TerrainTransforms.Append(Column.Terrain);
+        WaterTransforms.Append(Column.Water);
+        TreeTransforms.Append(Column.Trees);
+    }
 
-        Total += Noise * Amplitude;
+    TerrainISM->AddInstances(TerrainTransforms, false);
+    WaterISM->AddInstances(WaterTransforms, false);
+    TreeISM->AddInstances(TreeTransforms, false);
+}
 
-        MaxValue += Amplitude;
-        Amplitude *= Persistence;
-        Frequency *= Lacunarity;
-    }
 
-    return Total / MaxValue; // Normaliza para [0,1]
+FTerrainNoiseSettings APerlinMapGenerator::GetNoiseSettings() const
+{
+    FTerrainNoiseSettings Settings;
+    Settings.NoiseScale = NoiseScale;
+    Settings.Octaves = Octaves;
+    Settings.Persistence = Persistence;
+    Settings.Lacunarity = Lacunarity;
+    Settings.Seed = Seed;
+    return Settings;
 }
@@ -2,14 +2,29 @@
 
 
 #include "PerlinMapProceduralMeshGenerator.h"
+#include "TerrainChunkResidency.h"
+#include "TerrainGenerationCache.h"
+#include "TerrainHeightfieldFile.h"
+#include "TerrainNoiseCache.h"
+#include "TerrainQuantizedHeightfield.h"
 #include "DrawDebugHelpers.h"
 #include "Components/InstancedStaticMeshComponent.h"
 #include "Engine/StaticMesh.h"
+#include "Async/ParallelFor.h"
+#include "Async/Async.h"
+#include "Tasks/Task.h"
+#include "TimerManager.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/Paths.h"
 
 // Sets default values
 APerlinMapProceduralMeshGenerator::APerlinMapProceduralMeshGenerator()
 {
-    PrimaryActorTick.bCanEverTick = false;
+    // S tica enquanto h eroso incremental em andamento
+    PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.bStartWithTickEnabled = false;
 
     ProceduralMesh = CreateDefaultSubobject<UProceduralMeshComponent>(TEXT("ProceduralMesh"));
     RootComponent = ProceduralMesh;
@@ -52,87 +67,139 @@ void APerlinMapProceduralMeshGenerator::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+    if (!ErosionJob.IsActive() || bErosionJobPaused)
+    {
+        SetActorTickEnabled(false);
+        return;
+    }
+
+    const bool bFinished = ErosionJob.Advance(ErosionBudgetMs / 1000.0);
+    TimeSinceErosionRefresh += DeltaTime;
+
+    if (bFinished || TimeSinceErosionRefresh >= ErosionRefreshInterval)
+    {
+        RefreshErosionJob();
+    }
+
+    if (bFinished)
+    {
+        ErosionJob.Cancel();
+        SetActorTickEnabled(false);
+    }
 }
 
 void APerlinMapProceduralMeshGenerator::GenerateMap()
 {
-    const int32 NumVertsX = MapWidth + 1;
-    const int32 NumVertsY = MapHeight + 1;
-    const float TileSize = 100.0f;
+    if (bGenerationInProgress) return;
 
-    TArray<FVector> Vertices;
-    TArray<int32> Triangles;
-    TArray<FVector> Normals;
-    TArray<FVector2D> UVs;
-    TArray<FProcMeshTangent> Tangents;
+    FTerrainGenerationParams Params;
+    Params.MapWidth = MapWidth;
+    Params.MapHeight = MapHeight;
+    Params.HeightMultiplier = HeightMultiplier;
+    Params.ChunkSize = ChunkSize;
+    Params.NoiseSettings = GetNoiseSettings();
+    Params.bUseGenerationCache = bUseGenerationCache;
+    Params.GenerationCacheMaxBytes = (int64)FMath::Max(GenerationCacheMaxMB, 1) * 1024 * 1024;
 
-    FRandomStream RandStream(Seed);
+    TSharedRef<FTerrainGenerationResult> Result = MakeShared<FTerrainGenerationResult>();
 
-    // Gera vrtices
-    for (int32 Y = 0; Y < NumVertsY; ++Y)
+    if (!bGenerateAsync)
     {
-        for (int32 X = 0; X < NumVertsX; ++X)
-        {
-            float Noise = GeneratePerlinNoise(X, Y, RandStream);
-            float Height = Noise * HeightMultiplier;
-            Vertices.Add(FVector(X * TileSize, Y * TileSize, Height));
-            Normals.Add(FVector::UpVector); // Placeholder
-            UVs.Add(FVector2D((float)X / MapWidth, (float)Y / MapHeight));
-            Tangents.Add(FProcMeshTangent(1, 0, 0));
-        }
+        BuildTerrain(Params, *Result);
+        CommitTerrain(*Result);
+        return;
     }
 
-    // Gera tringulos (2 por quad)
-    for (int32 Y = 0; Y < MapHeight; ++Y)
+    bGenerationInProgress = true;
+
+    // Gera fora da game thread; s o commit da mesh volta para ela
+    TWeakObjectPtr<APerlinMapProceduralMeshGenerator> WeakThis(this);
+
+    UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, Params, Result]()
+    {
+        BuildTerrain(Params, *Result);
+
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, Result]()
+        {
+            if (APerlinMapProceduralMeshGenerator* Generator = WeakThis.Get())
+            {
+                Generator->bGenerationInProgress = false;
+                Generator->CommitTerrain(*Result);
+            }
+        });
+    });
+}
+
+void APerlinMapProceduralMeshGenerator::BuildTerrain(const FTerrainGenerationParams& Params, FTerrainGenerationResult& Result)
+{
+    // Alturas, rio e gua vm do cache em disco quando as entradas no mudaram
+    const uint64 CacheKey = ComputeGenerationKey(Params);
+
+    if (!Params.bUseGenerationCache ||
+        !FTerrainGenerationCache::Load(CacheKey, Result.Heightfield, Result.RiverPath, Result.WaterTransforms))
     {
-        for (int32 X = 0; X < MapWidth; ++X)
+        GenerateHeightfield(Params, Result);
+
+        if (Params.bUseGenerationCache)
         {
-            int32 i0 = Y * NumVertsX + X;
-            int32 i1 = i0 + 1;
-            int32 i2 = i0 + NumVertsX;
-            int32 i3 = i2 + 1;
-
-            // Tringulo 1
-            Triangles.Add(i0);
-            Triangles.Add(i2);
-            Triangles.Add(i1);
-
-            // Tringulo 2
-            Triangles.Add(i1);
-            Triangles.Add(i2);
-            Triangles.Add(i3);
+            if (!FTerrainGenerationCache::Save(CacheKey, Result.Heightfield, Result.RiverPath, Result.WaterTransforms))
+            {
+                UE_LOG(LogTemp, Warning, TEXT("Falha ao gravar o cache de terreno em %s"), *FTerrainGenerationCache::GetPath(CacheKey));
+            }
+
+            FTerrainGenerationCache::Trim(Params.GenerationCacheMaxBytes, CacheKey);
         }
     }
 
-    ProceduralMesh->CreateMeshSection_LinearColor(
-        0,
-        Vertices,
-        Triangles,
-        Normals,
-        UVs,
-        TArray<FLinearColor>(),
-        Tangents,
-        true
-    );
+    // Uma seo de mesh por chunk, montadas em paralelo
+    Result.Chunks.Init(Result.Heightfield, Params.ChunkSize);
+    Result.ChunkMeshes.SetNum(Result.Chunks.Num());
 
-    // Depois de gerar vrtices e tringulos
-    TerrainVertices = Vertices;
-    TerrainTriangles = Triangles;
-
-    ProceduralMesh->CreateMeshSection_LinearColor(
-        0,
-        TerrainVertices,
-        TerrainTriangles,
-        Normals,
-        UVs,
-        TArray<FLinearColor>(),
-        Tangents,
-        true
-    );
+    ParallelFor(Result.Chunks.Num(), [&](int32 ChunkIndex)
+    {
+        Result.ChunkMeshes[ChunkIndex].BuildSection(Result.Heightfield, Result.Chunks.GetVertexRegion(ChunkIndex));
+    });
+}
 
-    ProceduralMesh->SetMaterial(0, TerrainMaterial); // Se quiser aplicar material
-    ProceduralMesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-    ProceduralMesh->ContainsPhysicsTriMeshData(true);
+uint64 APerlinMapProceduralMeshGenerator::ComputeGenerationKey(const FTerrainGenerationParams& Params)
+{
+    // S o que muda alturas, rio ou gua (ChunkSize muda apenas a mesh)
+    FTerrainGenerationKey Key;
+    Key.Add(Params.MapWidth)
+        .Add(Params.MapHeight)
+        .Add(Params.HeightMultiplier)
+        .Add(Params.NoiseSettings.NoiseScale)
+        .Add(Params.NoiseSettings.Octaves)
+        .Add(Params.NoiseSettings.Persistence)
+        .Add(Params.NoiseSettings.Lacunarity)
+        .Add(Params.NoiseSettings.Seed);
+    return Key.Get();
+}
+
+void APerlinMapProceduralMeshGenerator::GenerateHeightfield(const FTerrainGenerationParams& Params, FTerrainGenerationResult& Result)
+{
+    const int32 NumVertsX = Params.MapWidth + 1;
+    const int32 NumVertsY = Params.MapHeight + 1;
+    const float TileSize = 100.0f;
+
+    Result.Heightfield.Init(NumVertsX, NumVertsY, TileSize);
+
+    // Rudo do mapa inteiro, vindo do cache de tiles compartilhado: regerar
+    // com o mesmo rudo (outra altura, outro rio, outro material) no
+    // reavalia nenhuma octava. As normais da mesh saem das alturas finais
+    // (BuildVertices), no das derivadas do rudo: as derivadas incluem
+    // octavas menores que uma clula e no seguiriam o rio nem as edies.
+    FTerrainNoiseTileCache::Get().SampleGrid(Params.NoiseSettings, 0, 0, NumVertsX, NumVertsY, Result.Heightfield.Heights.GetData());
+
+    ParallelFor(NumVertsY, [&](int32 Y)
+    {
+        float* Row = Result.Heightfield.Heights.GetData() + Y * NumVertsX;
+
+        for (int32 X = 0; X < NumVertsX; ++X)
+        {
+            Row[X] *= Params.HeightMultiplier;
+        }
+    });
 
     // Cria o leito do rio
     //FVector2D RiverStart(0, MapHeight * 50);     // ponto inicial (ajuste como quiser)
@@ -143,150 +210,311 @@ void APerlinMapProceduralMeshGenerator::GenerateMap()
     //CarveRiver(RiverStart, RiverEnd, RiverWidth, RiverDepth);
 
     // Gera um caminho de rio curvo com 50 pontos
-    FVector2D RiverStart(0, MapHeight * 50);
-    FVector2D RiverEnd(MapWidth * 100, MapHeight * 50);
+    FVector2D RiverStart(0, Params.MapHeight * 50);
+    FVector2D RiverEnd(Params.MapWidth * 100, Params.MapHeight * 50);
     float RiverWidth = 300.0f;
     float RiverDepth = 200.0f;
 
-    MainRiverPath = GenerateCurvedRiverPath(50, RiverStart, RiverEnd, 300.0f, 3.0f);
-    CarveCurvedRiver(MainRiverPath, RiverWidth, RiverDepth);
-
-    // Armazena o caminho principal
-    AllRiverPaths.Add(MainRiverPath);
+    Result.RiverPath = GenerateCurvedRiverPath(50, RiverStart, RiverEnd, 300.0f, 3.0f);
+    CarveRiverPath(Result.Heightfield, Result.RiverPath, RiverWidth, RiverDepth, Result.WaterTransforms);
 }
 
-
-float APerlinMapProceduralMeshGenerator::GeneratePerlinNoise(float X, float Y, FRandomStream& RandStream)
+void APerlinMapProceduralMeshGenerator::CommitTerrain(FTerrainGenerationResult& Result, const FTerrainHeightfieldFile* HeightsFile)
 {
-    float Total = 0.0f;
-    float Frequency = 6.5f;
-    float Amplitude = 100.0f;
-    float MaxValue = 0.0f;
+    TerrainHeightfield = MoveTemp(Result.Heightfield);
+    TerrainChunks = Result.Chunks;
+    DropletErosion.Reset();
 
-    for (int32 i = 0; i < Octaves; ++i)
+    // Modo quantizado: s as dimenses ficam em TerrainHeightfield
+    if (bQuantizeHeights)
     {
-        float SampleX = (X / NoiseScale) * Frequency;
-        float SampleY = (Y / NoiseScale) * Frequency;
+        const FTerrainQuantizationReport Report = HeightsFile
+            ? QuantizedHeights.Encode(HeightsFile->GetNumX(), HeightsFile->GetNumY(), HeightsFile->GetCellSize(), ChunkSize, [HeightsFile](const FTerrainDirtyRegion& Region, TArray<float>& OutHeights)
+            {
+                HeightsFile->ReadRegion(Region, OutHeights);
+            })
+            : QuantizedHeights.Encode(TerrainHeightfield, ChunkSize);
+        TerrainHeightfield.Heights.Empty();
 
-        // Rudo Perlin normalizado [0,1]
-        float Noise = FMath::PerlinNoise2D(FVector2D(SampleX, SampleY)) * 0.5f + 0.5f;
+        UE_LOG(LogTemp, Log, TEXT("Alturas quantizadas: %lld bytes (float: %lld), erro mx. %.3f, RMS %.3f"),
+            Report.QuantizedBytes, Report.FloatBytes, Report.MaxError, Report.RmsError);
+    }
+    else
+    {
+        QuantizedHeights.Reset();
+    }
 
-        Total += Noise * Amplitude;
+    // Camada fria: revisa periodicamente quais chunks podem ser comprimidos
+    GetWorldTimerManager().ClearTimer(ResidencyTimer);
 
-        MaxValue += Amplitude;
-        Amplitude *= Persistence;
-        Frequency *= Lacunarity;
+    if (bQuantizeHeights && bCompressColdChunks)
+    {
+        GetWorldTimerManager().SetTimer(ResidencyTimer, this, &APerlinMapProceduralMeshGenerator::UpdateChunkResidency, FMath::Max(ResidencyUpdateInterval, 0.1f), true);
     }
 
-    return Total / MaxValue; // Normaliza para [0,1]
+    ProceduralMesh->ClearAllMeshSections();
+
+    for (int32 ChunkIndex = 0; ChunkIndex < Result.ChunkMeshes.Num(); ++ChunkIndex)
+    {
+        const FTerrainChunkMesh& Chunk = Result.ChunkMeshes[ChunkIndex];
+
+        ProceduralMesh->CreateMeshSection_LinearColor(
+            ChunkIndex,
+            Chunk.Vertices,
+            Chunk.Triangles,
+            Chunk.Normals,
+            Chunk.UVs,
+            TArray<FLinearColor>(),
+            Chunk.Tangents,
+            true
+        );
+
+        ProceduralMesh->SetMaterial(ChunkIndex, TerrainMaterial); // Se quiser aplicar material
+    }
+
+    ProceduralMesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+    ProceduralMesh->ContainsPhysicsTriMeshData(true);
+
+    if (WaterISM && Result.WaterTransforms.Num() > 0)
+    {
+        WaterISM->AddInstances(Result.WaterTransforms, false);
+    }
+
+    // Armazena o caminho principal
+    MainRiverPath = MoveTemp(Result.RiverPath);
+    RiverNetwork.Reset();
+    RiverNetwork.AddPath(MainRiverPath);
+
+    bTerrainReady = true;
+    OnTerrainGenerated.Broadcast();
 }
 
-void APerlinMapProceduralMeshGenerator::ModifyTerrainAt(FVector WorldLocation, float Radius, float DeltaHeight)
+FTerrainNoiseSettings APerlinMapProceduralMeshGenerator::GetNoiseSettings() const
 {
-    if (TerrainVertices.Num() == 0) return;
+    FTerrainNoiseSettings Settings;
+    Settings.NoiseScale = NoiseScale;
+    Settings.Octaves = Octaves;
+    Settings.Persistence = Persistence;
+    Settings.Lacunarity = Lacunarity;
+    Settings.Seed = Seed;
+    return Settings;
+}
 
-    FVector LocalLocation = ProceduralMesh->GetComponentTransform().InverseTransformPosition(WorldLocation);
+bool APerlinMapProceduralMeshGenerator::IsTerrainReady() const
+{
+    return bTerrainReady;
+}
+
+FTerrainQuantizationReport APerlinMapProceduralMeshGenerator::GetHeightPrecisionReport() const
+{
+    return QuantizedHeights.GetReport();
+}
+
+FTerrainResidencySettings APerlinMapProceduralMeshGenerator::GetResidencySettings() const
+{
+    FTerrainResidencySettings Settings;
+    Settings.BudgetBytes = (int64)(ResidencyBudgetMB * 1024.0f * 1024.0f);
+    Settings.ColdDistance = ColdChunkDistance;
+    return Settings;
+}
 
-    for (int32 i = 0; i < TerrainVertices.Num(); ++i)
+void APerlinMapProceduralMeshGenerator::UpdateChunkResidency()
+{
+    if (QuantizedHeights.IsEmpty()) return;
+
+    // Observadores = pawns dos jogadores, no espao local da mesh
+    const FTransform& Transform = ProceduralMesh->GetComponentTransform();
+    TArray<FVector2D, TInlineAllocator<8>> Viewers;
+
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
     {
-        float Dist = FVector2D::Distance(
-            FVector2D(TerrainVertices[i].X, TerrainVertices[i].Y),
-            FVector2D(LocalLocation.X, LocalLocation.Y)
-        );
+        const APlayerController* Controller = It->Get();
+        const APawn* Pawn = Controller ? Controller->GetPawn() : nullptr;
 
-        if (Dist <= Radius)
+        if (Pawn)
         {
-            // Suavemente afeta os vrtices com base na distncia
-            float Falloff = 1.0f - (Dist / Radius);
-            TerrainVertices[i].Z += DeltaHeight * Falloff;
+            const FVector Local = Transform.InverseTransformPosition(Pawn->GetActorLocation());
+            Viewers.Add(FVector2D(Local.X, Local.Y));
         }
     }
 
-    // Atualiza a mesh
-    ProceduralMesh->UpdateMeshSection_LinearColor(
-        0,
-        TerrainVertices,
-        TArray<FVector>(),     // Normals (opcional)
-        TArray<FVector2D>(),   // UVs (opcional)
-        TArray<FLinearColor>(),
-        TArray<FProcMeshTangent>()
-    );
+    FTerrainChunkResidency::Update(QuantizedHeights, Viewers, GetResidencySettings());
+}
 
+FTerrainResidencyStats APerlinMapProceduralMeshGenerator::GetResidencyStats() const
+{
+    return FTerrainChunkResidency::GetStats(QuantizedHeights, GetResidencySettings());
 }
 
-void APerlinMapProceduralMeshGenerator::LevelTerrainAt(FVector WorldLocation, float Radius, float TargetHeight)
+bool APerlinMapProceduralMeshGenerator::HasTerrainHeights() const
 {
-    if (TerrainVertices.Num() == 0) return;
+    return !TerrainHeightfield.IsEmpty() || !QuantizedHeights.IsEmpty();
+}
 
-    FVector LocalLocation = ProceduralMesh->GetComponentTransform().InverseTransformPosition(WorldLocation);
+float APerlinMapProceduralMeshGenerator::GetTerrainHeight(int32 X, int32 Y) const
+{
+    return QuantizedHeights.IsEmpty() ? TerrainHeightfield.GetHeight(X, Y) : QuantizedHeights.GetHeight(X, Y);
+}
+
+FTerrainDirtyRegion APerlinMapProceduralMeshGenerator::GetTerrainRegionInBox(const FVector2D& BoxMin, const FVector2D& BoxMax) const
+{
+    return QuantizedHeights.IsEmpty() ? TerrainHeightfield.GetRegionInBox(BoxMin, BoxMax) : QuantizedHeights.GetRegionInBox(BoxMin, BoxMax);
+}
+
+FTerrainDirtyRegion APerlinMapProceduralMeshGenerator::GetTerrainRegionInRadius(const FVector2D& Center, float Radius) const
+{
+    return QuantizedHeights.IsEmpty() ? TerrainHeightfield.GetRegionInRadius(Center, Radius) : QuantizedHeights.GetRegionInRadius(Center, Radius);
+}
+
+FTerrainDirtyRegion APerlinMapProceduralMeshGenerator::EditHeights(const FTerrainDirtyRegion& Region, TFunctionRef<FTerrainDirtyRegion(FTerrainHeightfield&, const FVector2D&)> Edit, ETerrainChunkAccess Access)
+{
+    if (QuantizedHeights.IsEmpty())
+        return Edit(TerrainHeightfield, FVector2D::ZeroVector);
+
+    // Decodifica s a janela, edita em float e recodifica os chunks tocados
+    FTerrainHeightfield Window;
+    const FIntPoint Origin = QuantizedHeights.DecodeWindow(Region, Window, Access);
+    if (Window.IsEmpty()) return FTerrainDirtyRegion();
 
-    for (int32 i = 0; i < TerrainVertices.Num(); ++i)
+    FTerrainDirtyRegion Dirty = Edit(Window, FVector2D(Origin.X * Window.CellSize, Origin.Y * Window.CellSize));
+    if (Dirty.IsEmpty()) return Dirty;
+
+    Dirty.Min += Origin;
+    Dirty.Max += Origin;
+    QuantizedHeights.EncodeWindow(Window, Origin, Dirty, Access);
+    return Dirty;
+}
+
+void APerlinMapProceduralMeshGenerator::MarkTerrainDirty(const FTerrainDirtyRegion& Region)
+{
+    // +1 vrtice: as normais dos vizinhos dependem das alturas alteradas
+    TerrainChunks.MarkDirty(Region.ExpandBy(1));
+}
+
+void APerlinMapProceduralMeshGenerator::FlushDirtyChunks()
+{
+    TArray<int32> DirtyChunks;
+    TerrainChunks.ConsumeDirtyChunks(DirtyChunks);
+
+    if (DirtyChunks.Num() == 0) return;
+
+    // Monta vrtices, normais e tangentes dos chunks sujos em paralelo;
+    // o upload fica na game thread
+    TArray<FTerrainChunkMesh> ChunkMeshes;
+    ChunkMeshes.SetNum(DirtyChunks.Num());
+
+    ParallelFor(DirtyChunks.Num(), [&](int32 i)
     {
-        float Dist = FVector2D::Distance(
-            FVector2D(TerrainVertices[i].X, TerrainVertices[i].Y),
-            FVector2D(LocalLocation.X, LocalLocation.Y)
-        );
+        const FTerrainDirtyRegion VertexRegion = TerrainChunks.GetVertexRegion(DirtyChunks[i]);
 
-        if (Dist <= Radius)
+        if (QuantizedHeights.IsEmpty())
         {
-            // Aplicar falloff para suavizar a transio
-            float Falloff = 1.0f - (Dist / Radius);
-
-            // Interpola a altura atual at o valor desejado
-            TerrainVertices[i].Z = FMath::Lerp(TerrainVertices[i].Z, TargetHeight, Falloff);
+            ChunkMeshes[i].BuildVertices(TerrainHeightfield, VertexRegion);
+            return;
         }
+
+        // Decodifica o chunk e a borda de 1 vrtice lida pelas normais (s
+        // leitura para a mesh: no tira chunks da camada fria)
+        FTerrainHeightfield Window;
+        const FIntPoint Origin = QuantizedHeights.DecodeWindow(VertexRegion.ExpandBy(1), Window, ETerrainChunkAccess::Streaming);
+        ChunkMeshes[i].BuildVertices(Window, Origin, VertexRegion);
+    });
+
+    for (int32 i = 0; i < DirtyChunks.Num(); ++i)
+    {
+        ProceduralMesh->UpdateMeshSection_LinearColor(
+            DirtyChunks[i],
+            ChunkMeshes[i].Vertices,
+            ChunkMeshes[i].Normals,
+            TArray<FVector2D>(),   // UVs (opcional)
+            TArray<FLinearColor>(),
+            ChunkMeshes[i].Tangents
+        );
     }
+}
 
-    // Atualiza a mesh
-    ProceduralMesh->UpdateMeshSection_LinearColor(
-        0,
-        TerrainVertices,
-        TArray<FVector>(),     // Normals (opcional)
-        TArray<FVector2D>(),   // UVs (opcional)
-        TArray<FLinearColor>(),
-        TArray<FProcMeshTangent>()
-    );
+void APerlinMapProceduralMeshGenerator::ModifyTerrainAt(FVector WorldLocation, float Radius, float DeltaHeight)
+{
+    if (!HasTerrainHeights()) return;
+
+    FVector LocalLocation = ProceduralMesh->GetComponentTransform().InverseTransformPosition(WorldLocation);
+    const FVector2D Center(LocalLocation.X, LocalLocation.Y);
+
+    // S visita os vrtices dentro do retngulo do pincel
+    FTerrainDirtyRegion Dirty = EditHeights(GetTerrainRegionInRadius(Center, Radius), [&](FTerrainHeightfield& Heights, const FVector2D& Offset)
+    {
+        return Heights.RaiseInRadius(Center - Offset, Radius, DeltaHeight);
+    });
+
+    // Atualiza s os chunks afetados
+    MarkTerrainDirty(Dirty);
+    FlushDirtyChunks();
 }
 
-void APerlinMapProceduralMeshGenerator::CarveRiver(const FVector2D& Start, const FVector2D& End, float Width, float Depth)
+void APerlinMapProceduralMeshGenerator::LevelTerrainAt(FVector WorldLocation, float Radius, float TargetHeight)
 {
-    if (TerrainVertices.Num() == 0) return;
+    if (!HasTerrainHeights()) return;
+
+    FVector LocalLocation = ProceduralMesh->GetComponentTransform().InverseTransformPosition(WorldLocation);
+    const FVector2D Center(LocalLocation.X, LocalLocation.Y);
 
-    for (int32 i = 0; i < TerrainVertices.Num(); ++i)
+    // S visita os vrtices dentro do retngulo do pincel
+    FTerrainDirtyRegion Dirty = EditHeights(GetTerrainRegionInRadius(Center, Radius), [&](FTerrainHeightfield& Heights, const FVector2D& Offset)
     {
-        FVector& Vertex = TerrainVertices[i];
+        return Heights.LevelInRadius(Center - Offset, Radius, TargetHeight);
+    });
 
-        // Calcula distncia do vrtice  linha do rio (convertendo para FVector)
-        float Distance = FMath::PointDistToLine(
-            FVector(Vertex.X, Vertex.Y, 0.0f),
-            FVector(End.X - Start.X, End.Y - Start.Y, 0.0f),
-            FVector(Start.X, Start.Y, 0.0f)
-        );
+    // Atualiza s os chunks afetados
+    MarkTerrainDirty(Dirty);
+    FlushDirtyChunks();
+}
 
-        if (Distance <= Width)
-        {
-            float Falloff = 1.0f - (Distance / Width);
-            Vertex.Z -= Depth * Falloff;
+void APerlinMapProceduralMeshGenerator::CarveRiver(const FVector2D& Start, const FVector2D& End, float Width, float Depth)
+{
+    if (!HasTerrainHeights()) return;
+
+    // Janela = mapa inteiro (origem 0), ento as posies j so locais
+    FTerrainDirtyRegion Dirty = EditHeights(TerrainHeightfield.GetFullRegion(), [&](FTerrainHeightfield& Heights, const FVector2D&)
+    {
+        FTerrainDirtyRegion Carved;
 
-            // Adiciona gua
-            if (WaterISM)
+        for (int32 Y = 0; Y < Heights.NumY; ++Y)
+        {
+            for (int32 X = 0; X < Heights.NumX; ++X)
             {
-                FVector WaterLocation(Vertex.X, Vertex.Y, Vertex.Z + 1.0f);
-                FTransform WaterTransform(FRotator::ZeroRotator, WaterLocation, FVector(1.0f));
-                WaterISM->AddInstance(WaterTransform);
+                FVector2D Vertex2D = Heights.GetLocation2D(X, Y);
+                float& Height = Heights.GetHeight(X, Y);
+
+                // Calcula distncia do vrtice  linha do rio (convertendo para FVector)
+                float Distance = FMath::PointDistToLine(
+                    FVector(Vertex2D.X, Vertex2D.Y, 0.0f),
+                    FVector(End.X - Start.X, End.Y - Start.Y, 0.0f),
+                    FVector(Start.X, Start.Y, 0.0f)
+                );
+
+                if (Distance <= Width)
+                {
+                    float Falloff = 1.0f - (Distance / Width);
+                    Height -= Depth * Falloff;
+                    Carved.Include(X, Y);
+
+                    // Adiciona gua
+                    if (WaterISM)
+                    {
+                        FVector WaterLocation(Vertex2D.X, Vertex2D.Y, Height + 1.0f);
+                        FTransform WaterTransform(FRotator::ZeroRotator, WaterLocation, FVector(1.0f));
+                        WaterISM->AddInstance(WaterTransform);
+                    }
+                }
             }
         }
-    }
 
-    // Atualiza a mesh
-    ProceduralMesh->UpdateMeshSection_LinearColor(
-        0,
-        TerrainVertices,
-        TArray<FVector>(),     // Normals
-        TArray<FVector2D>(),   // UVs
-        TArray<FLinearColor>(),
-        TArray<FProcMeshTangent>()
-    );
+        return Carved;
+    }, ETerrainChunkAccess::Streaming);
+
+    // Atualiza s os chunks afetados
+    MarkTerrainDirty(Dirty);
+    FlushDirtyChunks();
 }
 
 TArray<FVector2D> APerlinMapProceduralMeshGenerator::GenerateCurvedRiverPath(int32 NumPoints, FVector2D Start, FVector2D End, float Amplitude, float Frequency)
@@ -316,56 +544,135 @@ TArray<FVector2D> APerlinMapProceduralMeshGenerator::GenerateCurvedRiverPath(int
 
 void APerlinMapProceduralMeshGenerator::CarveCurvedRiver(const TArray<FVector2D>& RiverPath, float Width, float Depth)
 {
-    if (TerrainVertices.Num() == 0 || RiverPath.Num() == 0) return;
+    if (!HasTerrainHeights() || RiverPath.Num() == 0) return;
 
-    for (int32 i = 0; i < TerrainVertices.Num(); ++i)
-    {
-        FVector& Vertex = TerrainVertices[i];
-        FVector2D Vertex2D(Vertex.X, Vertex.Y);
+    // S a janela do corredor  decodificada (ou visitada): o custo de um
+    // afluente no depende do tamanho do mapa
+    const FTerrainDirtyRegion Corridor = GetRiverCorridor(RiverPath, Width);
+    if (Corridor.IsEmpty()) return;
 
-        // Verifica a menor distncia do ponto ao caminho
-        float MinDistance = FLT_MAX;
+    TArray<FTransform> WaterTransforms;
+    FTerrainDirtyRegion Dirty = EditHeights(Corridor, [&](FTerrainHeightfield& Heights, const FVector2D& Offset)
+    {
+        TArray<FVector2D> LocalPath;
+        LocalPath.Reserve(RiverPath.Num());
 
-        for (int32 j = 0; j < RiverPath.Num() - 1; ++j)
+        for (const FVector2D& Point : RiverPath)
         {
-            FVector2D SegmentStart = RiverPath[j];
-            FVector2D SegmentEnd = RiverPath[j + 1];
+            LocalPath.Add(Point - Offset);
+        }
 
-            float Dist = FMath::PointDistToSegment(
-                FVector(Vertex.X, Vertex.Y, 0.0f),
-                FVector(SegmentStart.X, SegmentStart.Y, 0.0f),
-                FVector(SegmentEnd.X, SegmentEnd.Y, 0.0f)
-            );
+        const FTerrainDirtyRegion Carved = CarveRiverPath(Heights, LocalPath, Width, Depth, WaterTransforms);
 
-            MinDistance = FMath::Min(MinDistance, Dist);
+        for (FTransform& Transform : WaterTransforms)
+        {
+            Transform.AddToTranslation(FVector(Offset.X, Offset.Y, 0.0f));
         }
 
-        if (MinDistance <= Width)
-        {
-            float Falloff = 1.0f - (MinDistance / Width);
-            Vertex.Z -= Depth * Falloff;
+        return Carved;
+    });
+
+    // Instanciar gua
+    if (WaterISM && WaterTransforms.Num() > 0)
+    {
+        WaterISM->AddInstances(WaterTransforms, false);
+    }
+
+    // Atualiza s os chunks afetados
+    MarkTerrainDirty(Dirty);
+    FlushDirtyChunks();
+}
+
+FTerrainDirtyRegion APerlinMapProceduralMeshGenerator::CarveRiverPath(FTerrainHeightfield& Heightfield, const TArray<FVector2D>& RiverPath, float Width, float Depth, TArray<FTransform>& OutWaterTransforms)
+{
+    FTerrainDirtyRegion Dirty;
+
+    if (Heightfield.IsEmpty() || RiverPath.Num() < 2 || Width <= 0.0f) return Dirty;
 
-            // Instanciar gua
-            if (WaterISM)
+    // Vrtices a at Width de algum segmento, com a distncia a esse
+    // segmento. Cada segmento s visita a prpria caixa expandida por
+    // Width, ento nada aqui  proporcional ao retngulo do rio inteiro.
+    struct FCorridorCell
+    {
+        int32 Index;
+        float Distance;
+    };
+
+    TArray<FCorridorCell> Cells;
+
+    for (int32 j = 0; j < RiverPath.Num() - 1; ++j)
+    {
+        const FBox2D Box = GetRiverSegmentBox(RiverPath, j, Width);
+        const FTerrainDirtyRegion Region = Heightfield.GetRegionInBox(Box.Min, Box.Max);
+
+        const FVector SegmentStart(RiverPath[j].X, RiverPath[j].Y, 0.0f);
+        const FVector SegmentEnd(RiverPath[j + 1].X, RiverPath[j + 1].Y, 0.0f);
+
+        for (int32 Y = Region.Min.Y; Y < Region.Max.Y; ++Y)
+        {
+            for (int32 X = Region.Min.X; X < Region.Max.X; ++X)
             {
-                FVector WaterLocation(Vertex.X, Vertex.Y, Vertex.Z + 1.0f);
-                FTransform WaterTransform(FRotator::ZeroRotator, WaterLocation, FVector(1.0f));
-                WaterISM->AddInstance(WaterTransform);
+                FVector2D Vertex2D = Heightfield.GetLocation2D(X, Y);
+
+                float Dist = FMath::PointDistToSegment(FVector(Vertex2D.X, Vertex2D.Y, 0.0f), SegmentStart, SegmentEnd);
+                if (Dist > Width) continue;
+
+                Cells.Add({ Heightfield.GetIndex(X, Y), Dist });
             }
         }
     }
 
-    // Atualiza a mesh
-    ProceduralMesh->UpdateMeshSection_LinearColor(
-        0,
-        TerrainVertices,
-        TArray<FVector>(),     // Normals
-        TArray<FVector2D>(),   // UVs
-        TArray<FLinearColor>(),
-        TArray<FProcMeshTangent>()
+    // Ordem de linha da grade (gua instanciada na mesma ordem de antes); um
+    // vrtice coberto por vrios segmentos fica agrupado, menor distncia primeiro
+    Cells.Sort([](const FCorridorCell& A, const FCorridorCell& B)
+    {
+        return A.Index != B.Index ? A.Index < B.Index : A.Distance < B.Distance;
+    });
+
+    for (int32 i = 0; i < Cells.Num(); ++i)
+    {
+        if (i > 0 && Cells[i].Index == Cells[i - 1].Index) continue;
+
+        const int32 X = Cells[i].Index % Heightfield.NumX;
+        const int32 Y = Cells[i].Index / Heightfield.NumX;
+        FVector2D Vertex2D = Heightfield.GetLocation2D(X, Y);
+
+        float Falloff = 1.0f - (Cells[i].Distance / Width);
+        float& Height = Heightfield.GetHeight(X, Y);
+        Height -= Depth * Falloff;
+        Dirty.Include(X, Y);
+
+        // gua sobre o vrtice escavado
+        FVector WaterLocation(Vertex2D.X, Vertex2D.Y, Height + 1.0f);
+        OutWaterTransforms.Add(FTransform(FRotator::ZeroRotator, WaterLocation, FVector(1.0f)));
+    }
+
+    return Dirty;
+}
+
+FBox2D APerlinMapProceduralMeshGenerator::GetRiverSegmentBox(const TArray<FVector2D>& RiverPath, int32 Segment, float Width)
+{
+    return FBox2D(
+        RiverPath[Segment].ComponentMin(RiverPath[Segment + 1]) - FVector2D(Width, Width),
+        RiverPath[Segment].ComponentMax(RiverPath[Segment + 1]) + FVector2D(Width, Width)
     );
 }
 
+FTerrainDirtyRegion APerlinMapProceduralMeshGenerator::GetRiverCorridor(const TArray<FVector2D>& RiverPath, float Width) const
+{
+    FTerrainDirtyRegion Corridor;
+
+    if (Width <= 0.0f) return Corridor;
+
+    for (int32 j = 0; j < RiverPath.Num() - 1; ++j)
+    {
+        const FBox2D Box = GetRiverSegmentBox(RiverPath, j, Width);
+        Corridor.Include(GetTerrainRegionInBox(Box.Min, Box.Max));
+    }
+
+    return Corridor;
+}
+
 //Gera o afluente a partir do ponto inicial do rio
 //void APerlinMapProceduralMeshGenerator::AddTributaryAt(FVector StartLocation)
 //{
@@ -426,26 +733,13 @@ void APerlinMapProceduralMeshGenerator::CarveCurvedRiver(const TArray<FVector2D>
 
 void APerlinMapProceduralMeshGenerator::AddTributaryAt(FVector StartLocation)
 {
-    if (AllRiverPaths.Num() == 0 || TerrainVertices.Num() == 0) return;
+    if (RiverNetwork.NumPaths() == 0 || !HasTerrainHeights()) return;
 
     FVector2D Start2D(StartLocation.X, StartLocation.Y);
 
-    // Encontra o ponto mais prximo em TODOS os caminhos existentes (rio principal e afluentes)
-    float MinDistance = FLT_MAX;
-    FVector2D ClosestPoint = FVector2D::ZeroVector;
-
-    for (const TArray<FVector2D>& RiverPath : AllRiverPaths)
-    {
-        for (const FVector2D& Point : RiverPath)
-        {
-            float Dist = FVector2D::Distance(Start2D, Point);
-            if (Dist < MinDistance)
-            {
-                MinDistance = Dist;
-                ClosestPoint = Point;
-            }
-        }
-    }
+    // Ponto mais prximo em TODOS os caminhos existentes (rio principal e afluentes),
+    // sobre os segmentos e no s nos pontos de controle
+    const FVector2D ClosestPoint = RiverNetwork.FindNearest(Start2D).ClosestPoint;
 
     // Gera caminho curvo do ponto at o mais prximo
     int32 NumPoints = 20;
@@ -460,200 +754,373 @@ void APerlinMapProceduralMeshGenerator::AddTributaryAt(FVector StartLocation)
     CarveCurvedRiver(TributaryPath, TributaryWidth, TributaryDepth);
 
     // Armazena o afluente recm-gerado
-    AllRiverPaths.Add(TributaryPath);
+    RiverNetwork.AddPath(TributaryPath);
+}
+
+float APerlinMapProceduralMeshGenerator::GetDistanceToRiver(FVector WorldLocation) const
+{
+    const FVector Local = ProceduralMesh->GetComponentTransform().InverseTransformPosition(WorldLocation);
+    return RiverNetwork.GetDistanceToRiver(FVector2D(Local.X, Local.Y));
+}
+
+bool APerlinMapProceduralMeshGenerator::FindNearestRiverPoint(FVector WorldLocation, FVector& OutRiverPoint, float& OutDistance) const
+{
+    const FTransform& Transform = ProceduralMesh->GetComponentTransform();
+    const FVector Local = Transform.InverseTransformPosition(WorldLocation);
+    const FTerrainRiverHit Hit = RiverNetwork.FindNearest(FVector2D(Local.X, Local.Y));
+
+    if (!Hit.IsValid()) return false;
+
+    // Altura do terreno no vrtice mais prximo do ponto do rio
+    float Height = 0.0f;
+    if (HasTerrainHeights() && TerrainHeightfield.CellSize > 0.0f)
+    {
+        const int32 X = FMath::Clamp(FMath::RoundToInt(Hit.ClosestPoint.X / TerrainHeightfield.CellSize), 0, TerrainHeightfield.NumX - 1);
+        const int32 Y = FMath::Clamp(FMath::RoundToInt(Hit.ClosestPoint.Y / TerrainHeightfield.CellSize), 0, TerrainHeightfield.NumY - 1);
+        Height = GetTerrainHeight(X, Y);
+    }
+
+    OutRiverPoint = Transform.TransformPosition(FVector(Hit.ClosestPoint.X, Hit.ClosestPoint.Y, Height));
+    OutDistance = Hit.Distance;
+    return true;
+}
+
+bool APerlinMapProceduralMeshGenerator::IsNearRiver(FVector WorldLocation, float Radius) const
+{
+    return GetDistanceToRiver(WorldLocation) <= Radius;
 }
 
 void APerlinMapProceduralMeshGenerator::SimulateErosion(int32 NumIterations, float RainAmount, float ErosionStrength)
 {
-    if (TerrainVertices.Num() == 0 || MapWidth <= 0 || MapHeight <= 0)
+    if (!HasTerrainHeights())
         return;
 
-    const int32 NumVertsX = MapWidth + 1;
-    const int32 NumVertsY = MapHeight + 1;
+    FTerrainHydraulicSettings Settings;
+    Settings.RainAmount = RainAmount;
+    Settings.ErosionRate = FMath::Clamp(ErosionStrength, 0.0f, 1.0f);
 
-    TArray<float> Water;
-    Water.Init(0.0f, TerrainVertices.Num());
+    // Atualiza a mesh (o mapa inteiro foi afetado)
+    MarkTerrainDirty(EditHeights(TerrainHeightfield.GetFullRegion(), [&](FTerrainHeightfield& Heights, const FVector2D&)
+    {
+        FTerrainHydraulicErosion Erosion;
+        Erosion.Init(Heights, Settings);
+        Erosion.Step(NumIterations);
+        return Erosion.WriteBack(Heights);
+    }, ETerrainChunkAccess::Streaming));
+    FlushDirtyChunks();
+}
 
-    TArray<float> Erosion;
-    Erosion.Init(0.0f, TerrainVertices.Num());
+void APerlinMapProceduralMeshGenerator::SimulateErosionMultiResolution(int32 CoarseIterations, int32 FineIterations, int32 DownsampleFactor, float RainAmount, float ErosionStrength)
+{
+    if (!HasTerrainHeights())
+        return;
+
+    FTerrainHydraulicSettings Settings;
+    Settings.RainAmount = RainAmount;
+    Settings.ErosionRate = FMath::Clamp(ErosionStrength, 0.0f, 1.0f);
 
-    for (int32 Iter = 0; Iter < NumIterations; ++Iter)
+    MarkTerrainDirty(EditHeights(TerrainHeightfield.GetFullRegion(), [&](FTerrainHeightfield& Heights, const FVector2D&)
     {
-        // 1. Adiciona gua (chuva)
-        for (int32 i = 0; i < Water.Num(); ++i)
-        {
-            Water[i] += RainAmount;
-        }
+        return FTerrainMultiResolutionErosion::Run(Heights, Settings, DownsampleFactor, CoarseIterations, FineIterations);
+    }, ETerrainChunkAccess::Streaming));
+    FlushDirtyChunks();
+}
 
-        // 2. Move gua para os vizinhos mais baixos (simula escorrimento)
-        for (int32 Y = 0; Y < NumVertsY; ++Y)
-        {
-            for (int32 X = 0; X < NumVertsX; ++X)
-            {
-                int32 Index = Y * NumVertsX + X;
-                FVector Current = TerrainVertices[Index];
-                float CurrentHeight = Current.Z + Water[Index];
+void APerlinMapProceduralMeshGenerator::StartErosionJob(int32 NumIterations, float RainAmount, float ErosionStrength)
+{
+    if (!HasTerrainHeights())
+        return;
 
-                float LowestHeight = CurrentHeight;
-                int32 LowestNeighbor = -1;
+    FTerrainHydraulicSettings Settings;
+    Settings.RainAmount = RainAmount;
+    Settings.ErosionRate = FMath::Clamp(ErosionStrength, 0.0f, 1.0f);
 
-                // Verifica 4 vizinhos (N, S, E, W)
-                TArray<FIntPoint> Neighbors = {
-                    {X + 1, Y}, {X - 1, Y}, {X, Y + 1}, {X, Y - 1}
-                };
+    // O job copia as alturas; nada  escrito aqui
+    EditHeights(TerrainHeightfield.GetFullRegion(), [&](FTerrainHeightfield& Heights, const FVector2D&)
+    {
+        ErosionJob.Start(Heights, Settings, NumIterations);
+        return FTerrainDirtyRegion();
+    }, ETerrainChunkAccess::Streaming);
+    bErosionJobPaused = false;
+    TimeSinceErosionRefresh = 0.0f;
+    SetActorTickEnabled(true);
+}
 
-                for (FIntPoint Offset : Neighbors)
-                {
-                    if (Offset.X < 0 || Offset.X >= NumVertsX || Offset.Y < 0 || Offset.Y >= NumVertsY)
-                        continue;
+void APerlinMapProceduralMeshGenerator::PauseErosionJob()
+{
+    if (!ErosionJob.IsActive())
+        return;
 
-                    int32 NeighborIndex = Offset.Y * NumVertsX + Offset.X;
-                    float NeighborHeight = TerrainVertices[NeighborIndex].Z + Water[NeighborIndex];
+    bErosionJobPaused = true;
+    SetActorTickEnabled(false);
 
-                    if (NeighborHeight < LowestHeight)
-                    {
-                        LowestHeight = NeighborHeight;
-                        LowestNeighbor = NeighborIndex;
-                    }
-                }
+    // Mostra o estado em que a eroso parou
+    RefreshErosionJob();
+}
 
-                // Se encontrou vizinho mais baixo, move parte da gua
-                if (LowestNeighbor != -1)
-                {
-                    float FlowAmount = (CurrentHeight - LowestHeight) * 0.5f;
+void APerlinMapProceduralMeshGenerator::ResumeErosionJob()
+{
+    if (!ErosionJob.IsActive())
+        return;
 
-                    FlowAmount = FMath::Clamp(FlowAmount, 0.0f, Water[Index]);
+    bErosionJobPaused = false;
+    SetActorTickEnabled(true);
+}
+
+void APerlinMapProceduralMeshGenerator::CancelErosionJob()
+{
+    ErosionJob.Cancel();
+    bErosionJobPaused = false;
+    SetActorTickEnabled(false);
+}
 
-                    Water[Index] -= FlowAmount;
-                    Water[LowestNeighbor] += FlowAmount;
+bool APerlinMapProceduralMeshGenerator::IsErosionJobRunning() const
+{
+    return ErosionJob.IsActive() && !bErosionJobPaused;
+}
 
-                    // Marca eroso no local atual (gua desgasta o solo)
-                    Erosion[Index] += FlowAmount;
-                }
-            }
+float APerlinMapProceduralMeshGenerator::GetErosionProgress() const
+{
+    return ErosionJob.GetProgress();
+}
+
+void APerlinMapProceduralMeshGenerator::RefreshErosionJob()
+{
+    TimeSinceErosionRefresh = 0.0f;
+
+    if (QuantizedHeights.IsEmpty())
+    {
+        MarkTerrainDirty(ErosionJob.WriteBack(TerrainHeightfield));
+    }
+    else
+    {
+        // Um chunk por vez: nunca h uma cpia float do mapa inteiro alm da
+        // do job, e s os chunks em que alguma altura mudou so recodificados.
+        // Em Streaming, chunks frios continuam comprimidos.
+        for (int32 ChunkIndex = 0; ChunkIndex < QuantizedHeights.GetNumChunks(); ++ChunkIndex)
+        {
+            const FTerrainDirtyRegion Region = QuantizedHeights.GetChunkRegion(ChunkIndex);
+
+            MarkTerrainDirty(EditHeights(Region, [&](FTerrainHeightfield& Heights, const FVector2D&)
+            {
+                return ErosionJob.WriteBack(Heights, Region.Min);
+            }, ETerrainChunkAccess::Streaming));
         }
     }
+    FlushDirtyChunks();
+}
+
+void APerlinMapProceduralMeshGenerator::SimulateThermalErosion(int32 NumIterations, float TalusAngle)
+{
+    if (!HasTerrainHeights())
+        return;
+
+    FTerrainThermalSettings Settings;
+    Settings.TalusAngle = TalusAngle;
 
-    // 3. Esculpe o terreno com base na eroso acumulada
-    for (int32 i = 0; i < TerrainVertices.Num(); ++i)
+    MarkTerrainDirty(EditHeights(TerrainHeightfield.GetFullRegion(), [&](FTerrainHeightfield& Heights, const FVector2D&)
     {
-        TerrainVertices[i].Z -= Erosion[i] * ErosionStrength;
+        return FTerrainThermalErosion::Run(Heights, Settings, NumIterations);
+    }, ETerrainChunkAccess::Streaming));
+    FlushDirtyChunks();
+}
+
+bool APerlinMapProceduralMeshGenerator::BakeTiledErosion(const FString& Path, int32 WorldSizeX, int32 WorldSizeY, int32 TileSize, int32 NumPasses, int32 IterationsPerPass, float RainAmount, float ErosionStrength)
+{
+    const FString FullPath = FPaths::IsRelative(Path) ? FPaths::Combine(FPaths::ProjectSavedDir(), Path) : Path;
+
+    // Mesmo formato de ExportNoiseToHeightfieldFile/ImportHeightfieldFile
+    if (!ExportNoiseToHeightfieldFile(FullPath, WorldSizeX, WorldSizeY, TileSize))
+        return false;
+
+    FTerrainHydraulicSettings Settings;
+    Settings.RainAmount = RainAmount;
+    Settings.ErosionRate = FMath::Clamp(ErosionStrength, 0.0f, 1.0f);
+
+    // O halo cobre tudo o que a parede na borda da janela contamina numa
+    // passada: o miolo sai igual ao da mesma passada sem tiles (mas cada
+    // passada recomea sem gua nem sedimento)
+    const int32 Halo = FTerrainHydraulicErosion::GetReach(IterationsPerPass) + 1;
+
+    FTerrainHydraulicErosion Solver;
+    return FTerrainTiledErosion::Run(FullPath, Halo, NumPasses, [&Solver, &Settings, IterationsPerPass](FTerrainHeightfield& Window)
+    {
+        Solver.Init(Window, Settings);
+        Solver.Step(IterationsPerPass);
+        Solver.WriteBack(Window);
+    });
+}
+
+void APerlinMapProceduralMeshGenerator::SimulateDropletErosion(int32 NumDroplets, float ErosionStrength)
+{
+    if (!HasTerrainHeights())
+        return;
+
+    FTerrainDropletSettings Settings;
+    Settings.Seed = Seed;
+    Settings.ErodeSpeed = FMath::Clamp(ErosionStrength, 0.0f, 1.0f);
+
+    // Cada chamada simula gotas novas em vez de repetir as da anterior
+    if (!DropletErosion.IsInitialized() ||
+        DropletErosion.GetSettings().Seed != Settings.Seed ||
+        DropletErosion.GetSettings().ErodeSpeed != Settings.ErodeSpeed)
+    {
+        DropletErosion.Init(Settings);
     }
 
-    // 4. Atualiza a mesh
-    ProceduralMesh->UpdateMeshSection_LinearColor(
-        0,
-        TerrainVertices,
-        TArray<FVector>(),     // Normals
-        TArray<FVector2D>(),   // UVs
-        TArray<FLinearColor>(),
-        TArray<FProcMeshTangent>()
-    );
+    MarkTerrainDirty(EditHeights(TerrainHeightfield.GetFullRegion(), [&](FTerrainHeightfield& Heights, const FVector2D&)
+    {
+        return DropletErosion.Step(Heights, NumDroplets);
+    }, ETerrainChunkAccess::Streaming));
+    FlushDirtyChunks();
 }
 
 void APerlinMapProceduralMeshGenerator::SimulateErosionAt(FVector WorldLocation, float Radius, int32 NumIterations, float RainAmount, float ErosionStrength)
 {
-    if (TerrainVertices.Num() == 0 || MapWidth <= 0 || MapHeight <= 0)
+    if (!HasTerrainHeights())
         return;
 
-    const int32 NumVertsX = MapWidth + 1;
-    const int32 NumVertsY = MapHeight + 1;
-
     FVector LocalCenter = ProceduralMesh->GetComponentTransform().InverseTransformPosition(WorldLocation);
+    const FVector2D Center(LocalCenter.X, LocalCenter.Y);
+
+    // Janela com o halo de 1 vrtice que a eroso local l ao redor do raio
+    const FTerrainDirtyRegion Dirty = EditHeights(GetTerrainRegionInRadius(Center, Radius).ExpandBy(1), [&](FTerrainHeightfield& Heights, const FVector2D& Offset)
+    {
+        return LocalErosion.Run(Heights, Center - Offset, Radius, NumIterations, RainAmount, ErosionStrength);
+    });
+
+    // Atualiza s os chunks afetados
+    MarkTerrainDirty(Dirty);
+    FlushDirtyChunks();
+}
+
+void APerlinMapProceduralMeshGenerator::GetNoiseCacheStats(int64& OutHits, int64& OutMisses, int32& OutNumTiles)
+{
+    const FTerrainNoiseCacheStats Stats = FTerrainNoiseTileCache::Get().GetStats();
+    OutHits = Stats.Hits;
+    OutMisses = Stats.Misses;
+    OutNumTiles = Stats.NumTiles;
+}
 
-    TArray<float> Water;
-    Water.Init(0.0f, TerrainVertices.Num());
+void APerlinMapProceduralMeshGenerator::ClearNoiseCache()
+{
+    FTerrainNoiseTileCache::Get().Empty();
+}
 
-    TArray<float> Erosion;
-    Erosion.Init(0.0f, TerrainVertices.Num());
+void APerlinMapProceduralMeshGenerator::SetNoiseCacheBudget(int32 MegaBytes)
+{
+    FTerrainNoiseTileCache::Get().SetMaxBytes((int64)FMath::Max(MegaBytes, 1) * 1024 * 1024);
+}
 
-    // Pr-filtra os ndices dentro do raio da eroso
-    TArray<int32> AffectedIndices;
-    for (int32 i = 0; i < TerrainVertices.Num(); ++i)
+void APerlinMapProceduralMeshGenerator::ClearGenerationCache()
+{
+    if (!FTerrainGenerationCache::Clear())
     {
-        FVector2D Pos2D(TerrainVertices[i].X, TerrainVertices[i].Y);
-        FVector2D Center2D(LocalCenter.X, LocalCenter.Y);
-        float Dist = FVector2D::Distance(Pos2D, Center2D);
-        if (Dist <= Radius)
-        {
-            AffectedIndices.Add(i);
-        }
+        UE_LOG(LogTemp, Warning, TEXT("No foi possvel apagar %s"), *FTerrainGenerationCache::GetDirectory());
     }
+}
 
-    if (AffectedIndices.Num() == 0)
-        return;
+bool APerlinMapProceduralMeshGenerator::ExportHeightfieldFile(const FString& Path, int32 TileSize)
+{
+    if (!HasTerrainHeights()) return false;
+
+    const FString FullPath = FPaths::IsRelative(Path) ? FPaths::Combine(FPaths::ProjectSavedDir(), Path) : Path;
 
-    for (int32 Iter = 0; Iter < NumIterations; ++Iter)
+    bool bWritten = false;
+    EditHeights(TerrainHeightfield.GetFullRegion(), [&](FTerrainHeightfield& Heights, const FVector2D&)
     {
-        // 1. Chuva local
-        for (int32 i : AffectedIndices)
+        bWritten = FTerrainHeightfieldFile::Write(FullPath, Heights, TileSize);
+        return FTerrainDirtyRegion();
+    }, ETerrainChunkAccess::Streaming);
+    return bWritten;
+}
+
+bool APerlinMapProceduralMeshGenerator::ExportNoiseToHeightfieldFile(const FString& Path, int32 WorldSizeX, int32 WorldSizeY, int32 TileSize)
+{
+    const FString FullPath = FPaths::IsRelative(Path) ? FPaths::Combine(FPaths::ProjectSavedDir(), Path) : Path;
+
+    // Rudo direto (sem o cache de tiles): um bake grande s expulsaria do
+    // cache os tiles do mapa do ator
+    const FTerrainNoise Noise(GetNoiseSettings());
+    const float Multiplier = HeightMultiplier;
+
+    // Vrtices = quads + 1, como no mapa do ator
+    return FTerrainHeightfieldFile::Write(FullPath, WorldSizeX + 1, WorldSizeY + 1, TerrainHeightfield.CellSize, TileSize, [&Noise, Multiplier](const FTerrainDirtyRegion& Region, TArray<float>& OutHeights)
+    {
+        Noise.SampleGrid(Region.Min.X, Region.Min.Y, Region.Max.X - Region.Min.X, Region.Max.Y - Region.Min.Y, OutHeights.GetData());
+
+        for (float& Height : OutHeights)
         {
-            Water[i] += RainAmount;
+            Height *= Multiplier;
         }
+    });
+}
 
-        // 2. Espalhamento da gua (escorrimento)
-        for (int32 i : AffectedIndices)
-        {
-            int32 X = i % NumVertsX;
-            int32 Y = i / NumVertsX;
-            FVector Current = TerrainVertices[i];
-            float CurrentHeight = Current.Z + Water[i];
+bool APerlinMapProceduralMeshGenerator::ImportHeightfieldFile(const FString& Path)
+{
+    if (bGenerationInProgress) return false;
 
-            float LowestHeight = CurrentHeight;
-            int32 LowestNeighbor = -1;
+    const FString FullPath = FPaths::IsRelative(Path) ? FPaths::Combine(FPaths::ProjectSavedDir(), Path) : Path;
 
-            TArray<FIntPoint> Neighbors = {
-                {X + 1, Y}, {X - 1, Y}, {X, Y + 1}, {X, Y - 1}
-            };
+    FTerrainHeightfieldFile File;
+    if (!File.Open(FullPath))
+        return false;
 
-            for (FIntPoint Offset : Neighbors)
-            {
-                if (Offset.X < 0 || Offset.X >= NumVertsX || Offset.Y < 0 || Offset.Y >= NumVertsY)
-                    continue;
+    FTerrainGenerationResult Result;
+    const FIntPoint GridSize(File.GetNumX(), File.GetNumY());
 
-                int32 NeighborIndex = Offset.Y * NumVertsX + Offset.X;
-                float NeighborHeight = TerrainVertices[NeighborIndex].Z + Water[NeighborIndex];
+    // Quantizado: o mapa nunca fica inteiro em float, CommitTerrain codifica
+    // direto do arquivo. Sem quantizao o ator guarda as alturas em float
+    // de qualquer jeito, ento o arquivo  lido de uma vez.
+    if (bQuantizeHeights)
+    {
+        Result.Heightfield.NumX = GridSize.X;
+        Result.Heightfield.NumY = GridSize.Y;
+        Result.Heightfield.CellSize = File.GetCellSize();
+    }
+    else if (!File.ReadAll(Result.Heightfield))
+    {
+        return false;
+    }
 
-                if (NeighborHeight < LowestHeight)
-                {
-                    LowestHeight = NeighborHeight;
-                    LowestNeighbor = NeighborIndex;
-                }
-            }
+    // O arquivo s guarda alturas: terreno sem rio
+    Result.Chunks.Init(Result.Heightfield, ChunkSize);
+    Result.ChunkMeshes.SetNum(Result.Chunks.Num());
 
-            // Move gua se possvel
-            if (LowestNeighbor != -1)
-            {
-                float FlowAmount = (CurrentHeight - LowestHeight) * 0.5f;
-                FlowAmount = FMath::Clamp(FlowAmount, 0.0f, Water[i]);
+    ParallelFor(Result.Chunks.Num(), [&](int32 ChunkIndex)
+    {
+        const FTerrainDirtyRegion VertexRegion = Result.Chunks.GetVertexRegion(ChunkIndex);
 
-                Water[i] -= FlowAmount;
-                Water[LowestNeighbor] += FlowAmount;
+        if (!Result.Heightfield.IsEmpty())
+        {
+            Result.ChunkMeshes[ChunkIndex].BuildSection(Result.Heightfield, VertexRegion);
+            return;
+        }
 
-                Erosion[i] += FlowAmount;
+        // L s o chunk e a borda de 1 vrtice das normais (s essas
+        // pginas do arquivo so carregadas)
+        FTerrainDirtyRegion WindowRegion = VertexRegion.ExpandBy(1);
+        WindowRegion.Min = WindowRegion.Min.ComponentMax(FIntPoint(0, 0));
+        WindowRegion.Max = WindowRegion.Max.ComponentMin(GridSize);
 
-                // Se gua encontrar ponto muito fundo (canal do rio), amplifica eroso
-                if (TerrainVertices[LowestNeighbor].Z < Current.Z - 50.0f)
-                {
-                    Erosion[i] += FlowAmount * 1.5f; // Amplifica
-                }
-            }
-        }
-    }
+        FTerrainHeightfield Window;
+        Window.NumX = WindowRegion.Max.X - WindowRegion.Min.X;
+        Window.NumY = WindowRegion.Max.Y - WindowRegion.Min.Y;
+        Window.CellSize = File.GetCellSize();
+        File.ReadRegion(WindowRegion, Window.Heights);
+
+        Result.ChunkMeshes[ChunkIndex].BuildSection(Window, WindowRegion.Min, GridSize, VertexRegion);
+    });
 
-    // 3. Aplica a eroso ao terreno
-    for (int32 i : AffectedIndices)
+    // O terreno anterior sai de cena: a gua do rio antigo e uma eroso
+    // incremental em andamento (que sobrescreveria o mapa importado)
+    CancelErosionJob();
+
+    if (WaterISM)
     {
-        TerrainVertices[i].Z -= Erosion[i] * ErosionStrength;
+        WaterISM->ClearInstances();
     }
 
-    // 4. Atualiza a mesh
-    ProceduralMesh->UpdateMeshSection_LinearColor(
-        0,
-        TerrainVertices,
-        TArray<FVector>(),
-        TArray<FVector2D>(),
-        TArray<FLinearColor>(),
-        TArray<FProcMeshTangent>()
-    );
+    CommitTerrain(Result, &File);
+    return true;
 }
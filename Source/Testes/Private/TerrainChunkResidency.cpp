@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainChunkResidency.h"
+#include "TerrainQuantizedHeightfield.h"
+
+FTerrainResidencyStats FTerrainChunkResidency::Update(FTerrainQuantizedHeightfield& Heights, TArrayView<const FVector2D> Viewers, const FTerrainResidencySettings& Settings)
+{
+    if (Heights.IsEmpty()) return FTerrainResidencyStats();
+
+    const uint32 Clock = Heights.GetAccessClock();
+    const float CellSize = Heights.GetCellSize();
+
+    // Chunks residentes e ociosos, com a distância ao observador mais próximo
+    struct FCandidate
+    {
+        int32 ChunkIndex;
+        float Distance;
+    };
+
+    TArray<FCandidate> Candidates;
+
+    for (int32 ChunkIndex = 0; ChunkIndex < Heights.GetNumChunks(); ++ChunkIndex)
+    {
+        if (!Heights.IsChunkResident(ChunkIndex)) continue;
+        if (Clock - Heights.GetChunkLastAccess(ChunkIndex) < (uint32)FMath::Max(Settings.IdleUpdates, 0)) continue;
+
+        const FTerrainDirtyRegion Region = Heights.GetChunkRegion(ChunkIndex);
+        const FBox2D Bounds(FVector2D(Region.Min) * CellSize, FVector2D(Region.Max - FIntPoint(1, 1)) * CellSize);
+
+        // Sem observadores tudo é distante
+        float Distance = MAX_flt;
+        for (const FVector2D& Viewer : Viewers)
+        {
+            Distance = FMath::Min(Distance, (float)FMath::Sqrt(Bounds.ComputeSquaredDistanceToPoint(Viewer)));
+        }
+
+        Candidates.Add({ ChunkIndex, Distance });
+    }
+
+    // Mais distantes primeiro
+    Candidates.Sort([](const FCandidate& A, const FCandidate& B) { return A.Distance > B.Distance; });
+
+    int64 UsedBytes = Heights.GetAllocatedSize();
+
+    for (const FCandidate& Candidate : Candidates)
+    {
+        const bool bCold = Candidate.Distance > Settings.ColdDistance;
+        const bool bOverBudget = Settings.BudgetBytes > 0 && UsedBytes > Settings.BudgetBytes;
+
+        // A lista está em ordem de distância: daqui em diante nada é frio
+        if (!bCold && !bOverBudget) break;
+
+        UsedBytes -= Heights.CompressChunk(Candidate.ChunkIndex);
+    }
+
+    // Acessos a partir de agora contam para a próxima atualização
+    Heights.AdvanceAccessClock();
+
+    return GetStats(Heights, Settings);
+}
+
+FTerrainResidencyStats FTerrainChunkResidency::GetStats(const FTerrainQuantizedHeightfield& Heights, const FTerrainResidencySettings& Settings)
+{
+    FTerrainResidencyStats Stats;
+
+    for (int32 ChunkIndex = 0; ChunkIndex < Heights.GetNumChunks(); ++ChunkIndex)
+    {
+        if (Heights.IsChunkResident(ChunkIndex))
+            ++Stats.ResidentChunks;
+        else
+            ++Stats.CompressedChunks;
+    }
+
+    Stats.UsedBytes = Heights.GetAllocatedSize();
+    Stats.BudgetBytes = Settings.BudgetBytes;
+    Stats.Compressions = Heights.GetNumCompressions();
+    Stats.Decompressions = Heights.GetNumDecompressions();
+    return Stats;
+}
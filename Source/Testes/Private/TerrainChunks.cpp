@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainChunks.h"
+
+void FTerrainChunkGrid::Init(const FTerrainHeightfield& Heightfield, int32 InChunkSize)
+{
+    ChunkSize = FMath::Max(InChunkSize, 1);
+    LastVertexX = FMath::Max(Heightfield.NumX - 1, 0);
+    LastVertexY = FMath::Max(Heightfield.NumY - 1, 0);
+
+    NumChunksX = FMath::DivideAndRoundUp(LastVertexX, ChunkSize);
+    NumChunksY = FMath::DivideAndRoundUp(LastVertexY, ChunkSize);
+
+    DirtyChunks.Init(false, Num());
+}
+
+FTerrainDirtyRegion FTerrainChunkGrid::GetVertexRegion(int32 ChunkIndex) const
+{
+    const int32 ChunkX = ChunkIndex % NumChunksX;
+    const int32 ChunkY = ChunkIndex / NumChunksX;
+
+    FTerrainDirtyRegion Region;
+    Region.Min = FIntPoint(ChunkX * ChunkSize, ChunkY * ChunkSize);
+    Region.Max = FIntPoint(
+        FMath::Min(Region.Min.X + ChunkSize, LastVertexX) + 1,
+        FMath::Min(Region.Min.Y + ChunkSize, LastVertexY) + 1
+    );
+    return Region;
+}
+
+void FTerrainChunkGrid::MarkDirty(const FTerrainDirtyRegion& Region)
+{
+    if (Region.IsEmpty() || Num() == 0) return;
+
+    // Um vértice na borda pertence aos dois chunks vizinhos, por isso o -1 no mínimo
+    const int32 MinChunkX = FMath::Clamp((Region.Min.X - 1) / ChunkSize, 0, NumChunksX - 1);
+    const int32 MinChunkY = FMath::Clamp((Region.Min.Y - 1) / ChunkSize, 0, NumChunksY - 1);
+    const int32 MaxChunkX = FMath::Clamp((Region.Max.X - 1) / ChunkSize, 0, NumChunksX - 1);
+    const int32 MaxChunkY = FMath::Clamp((Region.Max.Y - 1) / ChunkSize, 0, NumChunksY - 1);
+
+    for (int32 ChunkY = MinChunkY; ChunkY <= MaxChunkY; ++ChunkY)
+    {
+        for (int32 ChunkX = MinChunkX; ChunkX <= MaxChunkX; ++ChunkX)
+        {
+            DirtyChunks[GetChunkIndex(ChunkX, ChunkY)] = true;
+        }
+    }
+}
+
+void FTerrainChunkGrid::MarkAllDirty()
+{
+    DirtyChunks.Init(true, Num());
+}
+
+void FTerrainChunkGrid::ConsumeDirtyChunks(TArray<int32>& OutChunks)
+{
+    OutChunks.Reset();
+
+    for (TConstSetBitIterator<> It(DirtyChunks); It; ++It)
+    {
+        OutChunks.Add(It.GetIndex());
+    }
+
+    DirtyChunks.Init(false, Num());
+}
+
+void FTerrainChunkMesh::BuildSection(const FTerrainHeightfield& Heightfield, const FTerrainDirtyRegion& VertexRegion)
+{
+    BuildVertices(Heightfield, VertexRegion);
+    BuildTopology(VertexRegion, FIntPoint(Heightfield.NumX, Heightfield.NumY));
+}
+
+void FTerrainChunkMesh::BuildSection(const FTerrainHeightfield& Window, const FIntPoint& Origin, const FIntPoint& GridSize, const FTerrainDirtyRegion& VertexRegion)
+{
+    BuildVertices(Window, Origin, VertexRegion);
+    BuildTopology(VertexRegion, GridSize);
+}
+
+void FTerrainChunkMesh::BuildVertices(const FTerrainHeightfield& Window, const FIntPoint& Origin, const FTerrainDirtyRegion& VertexRegion)
+{
+    FTerrainDirtyRegion LocalRegion = VertexRegion;
+    LocalRegion.Min -= Origin;
+    LocalRegion.Max -= Origin;
+    BuildVertices(Window, LocalRegion);
+
+    // Posições da janela -> posições da grade
+    const FVector Offset(Origin.X * Window.CellSize, Origin.Y * Window.CellSize, 0.0f);
+
+    for (FVector& Vertex : Vertices)
+    {
+        Vertex += Offset;
+    }
+}
+
+void FTerrainChunkMesh::BuildTopology(const FTerrainDirtyRegion& VertexRegion, const FIntPoint& GridSize)
+{
+    const int32 ChunkVertsX = VertexRegion.Max.X - VertexRegion.Min.X;
+    const int32 ChunkVertsY = VertexRegion.Max.Y - VertexRegion.Min.Y;
+    const int32 NumVerts = ChunkVertsX * ChunkVertsY;
+
+    const float InvQuadsX = 1.0f / FMath::Max(GridSize.X - 1, 1);
+    const float InvQuadsY = 1.0f / FMath::Max(GridSize.Y - 1, 1);
+
+    UVs.SetNumUninitialized(NumVerts);
+
+    for (int32 Y = 0; Y < ChunkVertsY; ++Y)
+    {
+        for (int32 X = 0; X < ChunkVertsX; ++X)
+        {
+            UVs[Y * ChunkVertsX + X] = FVector2D((VertexRegion.Min.X + X) * InvQuadsX, (VertexRegion.Min.Y + Y) * InvQuadsY);
+        }
+    }
+
+    // Gera triângulos (2 por quad), índices locais ao chunk
+    Triangles.SetNumUninitialized((ChunkVertsX - 1) * (ChunkVertsY - 1) * 6);
+    int32 TriIndex = 0;
+
+    for (int32 Y = 0; Y < ChunkVertsY - 1; ++Y)
+    {
+        for (int32 X = 0; X < ChunkVertsX - 1; ++X)
+        {
+            int32 i0 = Y * ChunkVertsX + X;
+            int32 i1 = i0 + 1;
+            int32 i2 = i0 + ChunkVertsX;
+            int32 i3 = i2 + 1;
+
+            // Triângulo 1
+            Triangles[TriIndex++] = i0;
+            Triangles[TriIndex++] = i2;
+            Triangles[TriIndex++] = i1;
+
+            // Triângulo 2
+            Triangles[TriIndex++] = i1;
+            Triangles[TriIndex++] = i2;
+            Triangles[TriIndex++] = i3;
+        }
+    }
+}
+
+void FTerrainChunkMesh::BuildVertices(const FTerrainHeightfield& Heightfield, const FTerrainDirtyRegion& VertexRegion)
+{
+    const int32 ChunkVertsX = VertexRegion.Max.X - VertexRegion.Min.X;
+    const int32 ChunkVertsY = VertexRegion.Max.Y - VertexRegion.Min.Y;
+
+    const int32 NumVerts = ChunkVertsX * ChunkVertsY;
+
+    Vertices.SetNumUninitialized(NumVerts);
+    Normals.SetNumUninitialized(NumVerts);
+    Tangents.SetNumUninitialized(NumVerts);
+
+    for (int32 Y = 0; Y < ChunkVertsY; ++Y)
+    {
+        for (int32 X = 0; X < ChunkVertsX; ++X)
+        {
+            const int32 Index = Y * ChunkVertsX + X;
+            const int32 GridX = VertexRegion.Min.X + X;
+            const int32 GridY = VertexRegion.Min.Y + Y;
+
+            FVector Tangent;
+            Vertices[Index] = Heightfield.GetVertex(GridX, GridY);
+            Heightfield.ComputeNormalAndTangent(GridX, GridY, Normals[Index], Tangent);
+            Tangents[Index] = FProcMeshTangent(Tangent, false);
+        }
+    }
+}
@@ -0,0 +1,842 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainErosion.h"
+#include "TerrainHeightfieldFile.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "TerrainRandom.h"
+
+void FTerrainHydraulicErosion::Init(const FTerrainHeightfield& Heightfield, const FTerrainHydraulicSettings& InSettings)
+{
+    Settings = InSettings;
+    NumX = Heightfield.NumX;
+    NumY = Heightfield.NumY;
+    CellSize = Heightfield.CellSize > 0.0f ? Heightfield.CellSize : 1.0f;
+    Rain = FMath::Max(Settings.RainAmount, 0.0f) / CellSize;
+    IterationsDone = 0;
+
+    NeighborOffsets[0] = -1;
+    NeighborOffsets[1] = 1;
+    NeighborOffsets[2] = -NumX;
+    NeighborOffsets[3] = NumX;
+
+    const int32 Num = Heightfield.Num();
+    const float InvCellSize = 1.0f / CellSize;
+
+    Terrain.SetNumUninitialized(Num);
+    for (int32 i = 0; i < Num; ++i)
+    {
+        Terrain[i] = Heightfield.Heights[i] * InvCellSize;
+    }
+
+    TerrainNext.SetNumUninitialized(Num);
+    Water.Init(0.0f, Num);
+    Sediment.Init(0.0f, Num);
+    SedimentNext.Init(0.0f, Num);
+    VelocityX.Init(0.0f, Num);
+    VelocityY.Init(0.0f, Num);
+    Flux.Init(0.0f, Num * 4);
+}
+
+void FTerrainHydraulicErosion::Step(int32 NumIterations)
+{
+    if (IsEmpty()) return;
+
+    for (int32 Iter = 0; Iter < NumIterations; ++Iter)
+    {
+        UpdateFlux();
+        UpdateWater();
+        ErodeAndDeposit();
+        TransportSediment();
+        ++IterationsDone;
+    }
+}
+
+void FTerrainHydraulicErosion::UpdateFlux()
+{
+    const float TimeStep = Settings.TimeStep;
+    const float FluxScale = TimeStep * Settings.PipeArea * Settings.Gravity;
+
+    // Cada célula só escreve os próprios canos e lê altura/água dos vizinhos.
+    // A chuva é uniforme, então não altera as diferenças de nível e só entra
+    // no limite de água disponível.
+    ParallelFor(NumY, [this, TimeStep, FluxScale](int32 Y)
+    {
+        for (int32 X = 0; X < NumX; ++X)
+        {
+            const int32 Index = Y * NumX + X;
+            const float Surface = Terrain[Index] + Water[Index];
+            float* CellFlux = &Flux[Index * 4];
+            float TotalFlux = 0.0f;
+
+            for (int32 Pipe = 0; Pipe < 4; ++Pipe)
+            {
+                if (!HasNeighbor(X, Y, Pipe))
+                {
+                    CellFlux[Pipe] = 0.0f;
+                    continue;
+                }
+
+                const int32 NeighborIndex = Index + NeighborOffsets[Pipe];
+                const float Delta = Surface - (Terrain[NeighborIndex] + Water[NeighborIndex]);
+
+                CellFlux[Pipe] = FMath::Max(0.0f, CellFlux[Pipe] + FluxScale * Delta);
+                TotalFlux += CellFlux[Pipe];
+            }
+
+            // Não deixa sair mais água do que a célula tem
+            const float Available = Water[Index] + Rain;
+            if (TotalFlux * TimeStep > Available && TotalFlux > 0.0f)
+            {
+                const float Scale = Available / (TotalFlux * TimeStep);
+                for (int32 Pipe = 0; Pipe < 4; ++Pipe)
+                {
+                    CellFlux[Pipe] *= Scale;
+                }
+            }
+        }
+    });
+}
+
+void FTerrainHydraulicErosion::UpdateWater()
+{
+    const float TimeStep = Settings.TimeStep;
+
+    // Lê só o fluxo (já fechado na passada anterior) e a própria água
+    ParallelFor(NumY, [this, TimeStep](int32 Y)
+    {
+        for (int32 X = 0; X < NumX; ++X)
+        {
+            const int32 Index = Y * NumX + X;
+            const float* CellFlux = &Flux[Index * 4];
+
+            float Inflow[4];
+            float TotalIn = 0.0f;
+            float TotalOut = 0.0f;
+
+            for (int32 Pipe = 0; Pipe < 4; ++Pipe)
+            {
+                // O vizinho na direção Pipe manda água pelo cano oposto (Pipe ^ 1)
+                Inflow[Pipe] = HasNeighbor(X, Y, Pipe) ? Flux[(Index + NeighborOffsets[Pipe]) * 4 + (Pipe ^ 1)] : 0.0f;
+                TotalIn += Inflow[Pipe];
+                TotalOut += CellFlux[Pipe];
+            }
+
+            const float OldDepth = Water[Index] + Rain;
+            const float NewDepth = FMath::Max(OldDepth + TimeStep * (TotalIn - TotalOut), 0.0f);
+            const float MeanDepth = 0.5f * (OldDepth + NewDepth);
+
+            Water[Index] = NewDepth;
+
+            // Vazão média que atravessa a célula em cada eixo
+            const float FlowX = 0.5f * (Inflow[0] - CellFlux[0] + CellFlux[1] - Inflow[1]);
+            const float FlowY = 0.5f * (Inflow[2] - CellFlux[2] + CellFlux[3] - Inflow[3]);
+
+            if (MeanDepth > KINDA_SMALL_NUMBER)
+            {
+                VelocityX[Index] = FlowX / MeanDepth;
+                VelocityY[Index] = FlowY / MeanDepth;
+            }
+            else
+            {
+                VelocityX[Index] = 0.0f;
+                VelocityY[Index] = 0.0f;
+            }
+        }
+    });
+}
+
+void FTerrainHydraulicErosion::ErodeAndDeposit()
+{
+    const float Evaporation = FMath::Clamp(1.0f - Settings.EvaporationRate * Settings.TimeStep, 0.0f, 1.0f);
+
+    // A inclinação lê as alturas vizinhas, então o resultado vai para TerrainNext
+    ParallelFor(NumY, [this, Evaporation](int32 Y)
+    {
+        const int32 Y0 = FMath::Max(Y - 1, 0);
+        const int32 Y1 = FMath::Min(Y + 1, NumY - 1);
+
+        for (int32 X = 0; X < NumX; ++X)
+        {
+            const int32 Index = Y * NumX + X;
+            const int32 X0 = FMath::Max(X - 1, 0);
+            const int32 X1 = FMath::Min(X + 1, NumX - 1);
+
+            const float SlopeX = (Terrain[Y * NumX + X1] - Terrain[Y * NumX + X0]) / FMath::Max(X1 - X0, 1);
+            const float SlopeY = (Terrain[Y1 * NumX + X] - Terrain[Y0 * NumX + X]) / FMath::Max(Y1 - Y0, 1);
+            const float SlopeSq = SlopeX * SlopeX + SlopeY * SlopeY;
+            const float SinTilt = FMath::Sqrt(SlopeSq / (1.0f + SlopeSq));
+
+            const float Speed = FMath::Sqrt(VelocityX[Index] * VelocityX[Index] + VelocityY[Index] * VelocityY[Index]);
+            const float Capacity = Settings.SedimentCapacity * FMath::Max(SinTilt, Settings.MinTilt) * Speed;
+
+            float Height = Terrain[Index];
+            float Carried = Sediment[Index];
+
+            if (Capacity > Carried)
+            {
+                const float Amount = Settings.ErosionRate * (Capacity - Carried);
+                Height -= Amount;
+                Carried += Amount;
+            }
+            else
+            {
+                const float Amount = Settings.DepositionRate * (Carried - Capacity);
+                Height += Amount;
+                Carried -= Amount;
+            }
+
+            TerrainNext[Index] = Height;
+            Sediment[Index] = Carried;
+            Water[Index] *= Evaporation;
+        }
+    });
+
+    Swap(Terrain, TerrainNext);
+}
+
+void FTerrainHydraulicErosion::TransportSediment()
+{
+    const float TimeStep = Settings.TimeStep;
+
+    // Semi-lagrangiano: cada célula busca o sedimento de onde a água veio.
+    // O recuo é limitado a 1 célula (CFL), o que fixa o alcance de GetReach.
+    ParallelFor(NumY, [this, TimeStep](int32 Y)
+    {
+        for (int32 X = 0; X < NumX; ++X)
+        {
+            const int32 Index = Y * NumX + X;
+            const float StepX = FMath::Clamp(VelocityX[Index] * TimeStep, -1.0f, 1.0f);
+            const float StepY = FMath::Clamp(VelocityY[Index] * TimeStep, -1.0f, 1.0f);
+            const float SourceX = FMath::Clamp(X - StepX, 0.0f, (float)(NumX - 1));
+            const float SourceY = FMath::Clamp(Y - StepY, 0.0f, (float)(NumY - 1));
+
+            const int32 X0 = FMath::FloorToInt(SourceX);
+            const int32 Y0 = FMath::FloorToInt(SourceY);
+            const int32 X1 = FMath::Min(X0 + 1, NumX - 1);
+            const int32 Y1 = FMath::Min(Y0 + 1, NumY - 1);
+            const float AlphaX = SourceX - X0;
+            const float AlphaY = SourceY - Y0;
+
+            const float Top = FMath::Lerp(Sediment[Y0 * NumX + X0], Sediment[Y0 * NumX + X1], AlphaX);
+            const float Bottom = FMath::Lerp(Sediment[Y1 * NumX + X0], Sediment[Y1 * NumX + X1], AlphaX);
+            SedimentNext[Index] = FMath::Lerp(Top, Bottom, AlphaY);
+        }
+    });
+
+    Swap(Sediment, SedimentNext);
+}
+
+FTerrainDirtyRegion FTerrainHydraulicErosion::WriteBack(FTerrainHeightfield& Heightfield) const
+{
+    if (Heightfield.NumX != NumX || Heightfield.NumY != NumY) return FTerrainDirtyRegion();
+
+    return WriteBack(Heightfield, FIntPoint(0, 0));
+}
+
+FTerrainDirtyRegion FTerrainHydraulicErosion::WriteBack(FTerrainHeightfield& Window, const FIntPoint& Origin) const
+{
+    FTerrainDirtyRegion Dirty;
+
+    if (IsEmpty() || Window.IsEmpty() || Origin.X < 0 || Origin.Y < 0 ||
+        Origin.X + Window.NumX > NumX || Origin.Y + Window.NumY > NumY)
+    {
+        return Dirty;
+    }
+
+    for (int32 Y = 0; Y < Window.NumY; ++Y)
+    {
+        const float* Source = &Terrain[(Origin.Y + Y) * NumX + Origin.X];
+
+        for (int32 X = 0; X < Window.NumX; ++X)
+        {
+            const float Height = Source[X] * CellSize;
+            float& Target = Window.GetHeight(X, Y);
+
+            if (Target != Height)
+            {
+                Target = Height;
+                Dirty.Include(X, Y);
+            }
+        }
+    }
+
+    return Dirty;
+}
+
+void FTerrainHydraulicErosion::Reset()
+{
+    Terrain.Empty();
+    TerrainNext.Empty();
+    Water.Empty();
+    Sediment.Empty();
+    SedimentNext.Empty();
+    VelocityX.Empty();
+    VelocityY.Empty();
+    Flux.Empty();
+    IterationsDone = 0;
+}
+
+void FTerrainErosionJob::Start(const FTerrainHeightfield& Heightfield, const FTerrainHydraulicSettings& Settings, int32 InTotalIterations)
+{
+    TotalIterations = FMath::Max(InTotalIterations, 0);
+    Solver.Init(Heightfield, Settings);
+}
+
+bool FTerrainErosionJob::Advance(double BudgetSeconds)
+{
+    if (!IsActive()) return false;
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    while (Solver.GetIterationsDone() < TotalIterations)
+    {
+        Solver.Step(1);
+
+        if (FPlatformTime::Seconds() - StartTime >= BudgetSeconds) break;
+    }
+
+    return IsFinished();
+}
+
+void FTerrainErosionJob::Cancel()
+{
+    Solver.Reset();
+    TotalIterations = 0;
+}
+
+float FTerrainErosionJob::GetProgress() const
+{
+    if (!IsActive()) return 0.0f;
+    if (TotalIterations == 0) return 1.0f;
+
+    return (float)Solver.GetIterationsDone() / TotalIterations;
+}
+
+FTerrainDirtyRegion FTerrainMultiResolutionErosion::Run(FTerrainHeightfield& Heightfield, const FTerrainHydraulicSettings& Settings, int32 Factor, int32 CoarseIterations, int32 FineIterations)
+{
+    if (Heightfield.IsEmpty()) return FTerrainDirtyRegion();
+
+    const int32 NumX = Heightfield.NumX;
+    const int32 NumY = Heightfield.NumY;
+    Factor = FMath::Clamp(Factor, 1, FMath::Max(FMath::Min(NumX, NumY) - 1, 1));
+
+    if (Factor > 1 && CoarseIterations > 0)
+    {
+        // 1. Reduz: cada vértice grosso é a média do bloco Factor x Factor em
+        // volta dele. O último vértice grosso pode cair além da grade fina;
+        // o bloco dele é preso à borda para nunca ficar vazio.
+        FTerrainHeightfield Coarse;
+        Coarse.Init(FMath::DivideAndRoundUp(NumX - 1, Factor) + 1, FMath::DivideAndRoundUp(NumY - 1, Factor) + 1, Heightfield.CellSize * Factor);
+
+        const int32 HalfBlock = Factor / 2;
+        ParallelFor(Coarse.NumY, [&Heightfield, &Coarse, Factor, HalfBlock, NumX, NumY](int32 CoarseY)
+        {
+            const int32 MinY = FMath::Clamp(CoarseY * Factor - HalfBlock, 0, NumY - 1);
+            const int32 MaxY = FMath::Clamp(CoarseY * Factor + HalfBlock, MinY, NumY - 1);
+
+            for (int32 CoarseX = 0; CoarseX < Coarse.NumX; ++CoarseX)
+            {
+                const int32 MinX = FMath::Clamp(CoarseX * Factor - HalfBlock, 0, NumX - 1);
+                const int32 MaxX = FMath::Clamp(CoarseX * Factor + HalfBlock, MinX, NumX - 1);
+
+                float Sum = 0.0f;
+                for (int32 Y = MinY; Y <= MaxY; ++Y)
+                {
+                    for (int32 X = MinX; X <= MaxX; ++X)
+                    {
+                        Sum += Heightfield.GetHeight(X, Y);
+                    }
+                }
+
+                Coarse.GetHeight(CoarseX, CoarseY) = Sum / ((MaxX - MinX + 1) * (MaxY - MinY + 1));
+            }
+        });
+
+        // 2. Simula na grade grossa; Delta = quanto cada vértice grosso mudou
+        FTerrainHydraulicErosion CoarseSolver;
+        CoarseSolver.Init(Coarse, Settings);
+        CoarseSolver.Step(CoarseIterations);
+
+        TArray<float> Delta = Coarse.Heights;
+        CoarseSolver.WriteBack(Coarse);
+        for (int32 i = 0; i < Delta.Num(); ++i)
+        {
+            Delta[i] = Coarse.Heights[i] - Delta[i];
+        }
+
+        // 3. Interpola a diferença (bilinear) e soma nas alturas originais
+        const float InvFactor = 1.0f / Factor;
+        ParallelFor(NumY, [&Heightfield, &Coarse, &Delta, InvFactor, NumX](int32 Y)
+        {
+            const float CoarseYf = Y * InvFactor;
+            const int32 Y0 = FMath::Min(FMath::FloorToInt(CoarseYf), Coarse.NumY - 1);
+            const int32 Y1 = FMath::Min(Y0 + 1, Coarse.NumY - 1);
+            const float AlphaY = CoarseYf - Y0;
+
+            for (int32 X = 0; X < NumX; ++X)
+            {
+                const float CoarseXf = X * InvFactor;
+                const int32 X0 = FMath::Min(FMath::FloorToInt(CoarseXf), Coarse.NumX - 1);
+                const int32 X1 = FMath::Min(X0 + 1, Coarse.NumX - 1);
+                const float AlphaX = CoarseXf - X0;
+
+                const float Top = FMath::Lerp(Delta[Coarse.GetIndex(X0, Y0)], Delta[Coarse.GetIndex(X1, Y0)], AlphaX);
+                const float Bottom = FMath::Lerp(Delta[Coarse.GetIndex(X0, Y1)], Delta[Coarse.GetIndex(X1, Y1)], AlphaX);
+                Heightfield.GetHeight(X, Y) += FMath::Lerp(Top, Bottom, AlphaY);
+            }
+        });
+    }
+
+    // 4. Poucas iterações na resolução cheia para o detalhe fino
+    if (FineIterations > 0)
+    {
+        FTerrainHydraulicErosion FineSolver;
+        FineSolver.Init(Heightfield, Settings);
+        FineSolver.Step(FineIterations);
+        FineSolver.WriteBack(Heightfield);
+    }
+
+    return Heightfield.GetFullRegion();
+}
+
+FTerrainDirtyRegion FTerrainThermalErosion::Run(FTerrainHeightfield& Heightfield, const FTerrainThermalSettings& Settings, int32 NumIterations)
+{
+    FTerrainDirtyRegion Dirty;
+
+    if (Heightfield.IsEmpty() || NumIterations <= 0) return Dirty;
+
+    const int32 NumX = Heightfield.NumX;
+    const int32 NumY = Heightfield.NumY;
+
+    // Desnível máximo antes de escorregar, para vizinhos retos e diagonais
+    const float Talus = FMath::Tan(FMath::DegreesToRadians(FMath::Clamp(Settings.TalusAngle, 0.0f, 89.0f))) * Heightfield.CellSize;
+    const float TalusDiagonal = Talus * UE_SQRT_2;
+
+    // Cada um dos 8 pares recebe no máximo 1/8 do excesso, então a célula
+    // nunca perde mais do que tem acima dos vizinhos
+    const float PairRate = FMath::Clamp(Settings.Rate, 0.0f, 1.0f) * 0.5f / 8.0f;
+
+    static const int32 OffsetX[8] = { -1, 1, 0, 0, -1, 1, -1, 1 };
+    static const int32 OffsetY[8] = { 0, 0, -1, 1, -1, -1, 1, 1 };
+
+    TArray<float> Source = Heightfield.Heights;
+    TArray<float> Target;
+    Target.SetNumUninitialized(Source.Num());
+
+    // Vértices alterados em cada linha [Min, Max) somando todas as iterações
+    TArray<FIntPoint> RowChanges;
+    RowChanges.Init(FIntPoint(MAX_int32, MIN_int32), NumY);
+
+    for (int32 Iter = 0; Iter < NumIterations; ++Iter)
+    {
+        ParallelFor(NumY, [&Source, &Target, &RowChanges, NumX, NumY, Talus, TalusDiagonal, PairRate](int32 Y)
+        {
+            FIntPoint& Changed = RowChanges[Y];
+
+            for (int32 X = 0; X < NumX; ++X)
+            {
+                const int32 Index = Y * NumX + X;
+                const float Height = Source[Index];
+                float Transfer = 0.0f;
+
+                for (int32 n = 0; n < 8; ++n)
+                {
+                    const int32 NeighborX = X + OffsetX[n];
+                    const int32 NeighborY = Y + OffsetY[n];
+
+                    if (NeighborX < 0 || NeighborX >= NumX || NeighborY < 0 || NeighborY >= NumY)
+                        continue;
+
+                    // Positivo quando o vizinho é mais alto (recebe material dele)
+                    const float Difference = Source[NeighborY * NumX + NeighborX] - Height;
+                    const float Excess = FMath::Abs(Difference) - (n < 4 ? Talus : TalusDiagonal);
+
+                    if (Excess > 0.0f)
+                    {
+                        Transfer += FMath::Sign(Difference) * Excess * PairRate;
+                    }
+                }
+
+                Target[Index] = Height + Transfer;
+
+                if (Transfer != 0.0f)
+                {
+                    Changed.X = FMath::Min(Changed.X, X);
+                    Changed.Y = FMath::Max(Changed.Y, X + 1);
+                }
+            }
+        });
+
+        Swap(Source, Target);
+    }
+
+    Heightfield.Heights = MoveTemp(Source);
+
+    for (int32 Y = 0; Y < NumY; ++Y)
+    {
+        if (RowChanges[Y].X < RowChanges[Y].Y)
+        {
+            Dirty.Include(RowChanges[Y].X, Y);
+            Dirty.Include(RowChanges[Y].Y - 1, Y);
+        }
+    }
+
+    return Dirty;
+}
+
+namespace TerrainErosionPrivate
+{
+    // Altura bilinear em (X, Y) e gradiente dentro da célula. Exige
+    // 0 <= X < NumX - 1 e 0 <= Y < NumY - 1.
+    FORCEINLINE float SampleHeight(const FTerrainHeightfield& Heightfield, float Scale, float X, float Y, float& OutGradX, float& OutGradY)
+    {
+        const int32 CellX = FMath::FloorToInt(X);
+        const int32 CellY = FMath::FloorToInt(Y);
+        const float AlphaX = X - CellX;
+        const float AlphaY = Y - CellY;
+
+        const int32 Index = CellY * Heightfield.NumX + CellX;
+        const float H00 = Heightfield.Heights[Index] * Scale;
+        const float H10 = Heightfield.Heights[Index + 1] * Scale;
+        const float H01 = Heightfield.Heights[Index + Heightfield.NumX] * Scale;
+        const float H11 = Heightfield.Heights[Index + Heightfield.NumX + 1] * Scale;
+
+        OutGradX = (H10 - H00) * (1.0f - AlphaY) + (H11 - H01) * AlphaY;
+        OutGradY = (H01 - H00) * (1.0f - AlphaX) + (H11 - H10) * AlphaX;
+
+        return FMath::Lerp(FMath::Lerp(H00, H10, AlphaX), FMath::Lerp(H01, H11, AlphaX), AlphaY);
+    }
+}
+
+void FTerrainDropletErosion::Init(const FTerrainDropletSettings& InSettings)
+{
+    Settings = InSettings;
+    Settings.DropletsPerBatch = FMath::Max(Settings.DropletsPerBatch, 1);
+    Settings.BatchesPerRound = FMath::Max(Settings.BatchesPerRound, 1);
+    DropletsDone = 0;
+    Batches.SetNum(Settings.BatchesPerRound);
+}
+
+void FTerrainDropletErosion::Reset()
+{
+    Batches.Empty();
+    DropletsDone = 0;
+}
+
+FTerrainDirtyRegion FTerrainDropletErosion::Step(FTerrainHeightfield& Heightfield, int32 NumDroplets)
+{
+    FTerrainDirtyRegion Dirty;
+
+    if (Heightfield.NumX < 2 || Heightfield.NumY < 2 || NumDroplets <= 0) return Dirty;
+
+    const float CellSize = Heightfield.CellSize > 0.0f ? Heightfield.CellSize : 1.0f;
+    const int32 LastDroplet = DropletsDone + NumDroplets;
+
+    while (DropletsDone < LastDroplet)
+    {
+        const int32 RoundStart = DropletsDone;
+        const int32 RoundCount = FMath::Min(LastDroplet - RoundStart, Settings.DropletsPerBatch * Settings.BatchesPerRound);
+        const int32 NumBatches = FMath::DivideAndRoundUp(RoundCount, Settings.DropletsPerBatch);
+
+        // Todos os lotes leem as mesmas alturas; nada é escrito no heightfield aqui
+        const FTerrainHeightfield& Snapshot = Heightfield;
+        ParallelFor(NumBatches, [this, &Snapshot, RoundStart, RoundCount](int32 BatchIndex)
+        {
+            FBatch& Batch = Batches[BatchIndex];
+            Batch.Deltas.Reset();
+            Batch.Dirty = FTerrainDirtyRegion();
+
+            const int32 First = BatchIndex * Settings.DropletsPerBatch;
+            const int32 Last = FMath::Min(First + Settings.DropletsPerBatch, RoundCount);
+
+            for (int32 i = First; i < Last; ++i)
+            {
+                SimulateDroplet(Snapshot, RoundStart + i, Batch);
+            }
+        });
+
+        // Aplica em ordem de lote para não depender de qual thread terminou antes
+        for (int32 BatchIndex = 0; BatchIndex < NumBatches; ++BatchIndex)
+        {
+            const FBatch& Batch = Batches[BatchIndex];
+
+            for (const FHeightDelta& Delta : Batch.Deltas)
+            {
+                Heightfield.Heights[Delta.Index] += Delta.Delta * CellSize;
+            }
+
+            Dirty.Include(Batch.Dirty);
+        }
+
+        DropletsDone += RoundCount;
+    }
+
+    return Dirty;
+}
+
+void FTerrainDropletErosion::SimulateDroplet(const FTerrainHeightfield& Heightfield, int32 DropletIndex, FBatch& Batch) const
+{
+    using namespace TerrainErosionPrivate;
+
+    const int32 NumX = Heightfield.NumX;
+    const float Scale = 1.0f / (Heightfield.CellSize > 0.0f ? Heightfield.CellSize : 1.0f);
+    const float MaxX = (float)(NumX - 1);
+    const float MaxY = (float)(Heightfield.NumY - 1);
+
+    FTerrainRandomStream Stream(Settings.Seed, DropletIndex, 0, ETerrainRandomPurpose::Droplet);
+
+    float PosX = Stream.FRandRange(0.0f, MaxX - KINDA_SMALL_NUMBER);
+    float PosY = Stream.FRandRange(0.0f, MaxY - KINDA_SMALL_NUMBER);
+    float DirX = 0.0f;
+    float DirY = 0.0f;
+    float Speed = Settings.InitialSpeed;
+    float Water = Settings.InitialWater;
+    float Sediment = 0.0f;
+
+    // Espalha Amount nos 4 vértices da célula de (X, Y), com pesos bilineares
+    auto AddToCell = [&Batch, NumX](float X, float Y, float Amount)
+    {
+        const int32 CellX = FMath::FloorToInt(X);
+        const int32 CellY = FMath::FloorToInt(Y);
+        const float AlphaX = X - CellX;
+        const float AlphaY = Y - CellY;
+        const int32 Index = CellY * NumX + CellX;
+
+        Batch.Deltas.Add({ Index, Amount * (1.0f - AlphaX) * (1.0f - AlphaY) });
+        Batch.Deltas.Add({ Index + 1, Amount * AlphaX * (1.0f - AlphaY) });
+        Batch.Deltas.Add({ Index + NumX, Amount * (1.0f - AlphaX) * AlphaY });
+        Batch.Deltas.Add({ Index + NumX + 1, Amount * AlphaX * AlphaY });
+
+        Batch.Dirty.Include(CellX, CellY);
+        Batch.Dirty.Include(CellX + 1, CellY + 1);
+    };
+
+    for (int32 Life = 0; Life < Settings.MaxLifetime; ++Life)
+    {
+        float GradX, GradY;
+        const float Height = SampleHeight(Heightfield, Scale, PosX, PosY, GradX, GradY);
+
+        // Mistura a direção anterior com a descida do gradiente
+        DirX = DirX * Settings.Inertia - GradX * (1.0f - Settings.Inertia);
+        DirY = DirY * Settings.Inertia - GradY * (1.0f - Settings.Inertia);
+
+        const float DirLength = FMath::Sqrt(DirX * DirX + DirY * DirY);
+        if (DirLength <= KINDA_SMALL_NUMBER) break;
+
+        DirX /= DirLength;
+        DirY /= DirLength;
+
+        const float NewX = PosX + DirX;
+        const float NewY = PosY + DirY;
+
+        if (NewX < 0.0f || NewX >= MaxX || NewY < 0.0f || NewY >= MaxY) break;
+
+        float NewGradX, NewGradY;
+        const float DeltaHeight = SampleHeight(Heightfield, Scale, NewX, NewY, NewGradX, NewGradY) - Height;
+
+        const float Capacity = FMath::Max(-DeltaHeight * Speed * Water * Settings.SedimentCapacity, Settings.MinCapacity);
+
+        if (Sediment > Capacity || DeltaHeight > 0.0f)
+        {
+            // Subindo: preenche o buraco; senão deposita o excesso
+            const float Amount = DeltaHeight > 0.0f
+                ? FMath::Min(DeltaHeight, Sediment)
+                : (Sediment - Capacity) * Settings.DepositSpeed;
+
+            Sediment -= Amount;
+            AddToCell(PosX, PosY, Amount);
+        }
+        else
+        {
+            // Nunca cava mais que o desnível (evita buracos)
+            const float Amount = FMath::Min((Capacity - Sediment) * Settings.ErodeSpeed, -DeltaHeight);
+
+            Sediment += Amount;
+            AddToCell(PosX, PosY, -Amount);
+        }
+
+        Speed = FMath::Sqrt(FMath::Max(Speed * Speed - DeltaHeight * Settings.Gravity, 0.0f));
+        Water *= 1.0f - Settings.EvaporateSpeed;
+        PosX = NewX;
+        PosY = NewY;
+    }
+}
+
+FTerrainDirtyRegion FTerrainLocalErosion::Run(FTerrainHeightfield& Heightfield, const FVector2D& Center, float Radius, int32 NumIterations, float RainAmount, float ErosionStrength)
+{
+    FTerrainDirtyRegion Dirty;
+
+    const FTerrainDirtyRegion Inner = Heightfield.GetRegionInRadius(Center, Radius);
+    if (Inner.IsEmpty()) return Dirty;
+
+    // Janela = raio + halo de 1 vértice, limitada à grade
+    FTerrainDirtyRegion Window = Inner.ExpandBy(1);
+    Window.Min = Window.Min.ComponentMax(FIntPoint(0, 0));
+    Window.Max = Window.Max.ComponentMin(FIntPoint(Heightfield.NumX, Heightfield.NumY));
+
+    const int32 WindowX = Window.Max.X - Window.Min.X;
+    const int32 WindowY = Window.Max.Y - Window.Min.Y;
+    const int32 WindowNum = WindowX * WindowY;
+
+    Ground.SetNumUninitialized(WindowNum);
+    Water.Init(0.0f, WindowNum);
+    Erosion.Init(0.0f, WindowNum);
+    Affected.Reset();
+
+    for (int32 Y = 0; Y < WindowY; ++Y)
+    {
+        FMemory::Memcpy(&Ground[Y * WindowX], &Heightfield.Heights[Heightfield.GetIndex(Window.Min.X, Window.Min.Y + Y)], WindowX * sizeof(float));
+    }
+
+    const float RadiusSq = Radius * Radius;
+
+    for (int32 Y = Inner.Min.Y; Y < Inner.Max.Y; ++Y)
+    {
+        for (int32 X = Inner.Min.X; X < Inner.Max.X; ++X)
+        {
+            if (FVector2D::DistSquared(Heightfield.GetLocation2D(X, Y), Center) <= RadiusSq)
+            {
+                Affected.Add((Y - Window.Min.Y) * WindowX + (X - Window.Min.X));
+            }
+        }
+    }
+
+    if (Affected.Num() == 0) return Dirty;
+
+    // Vizinhos N, S, E, W. A janela termina no halo ou na borda da grade, então
+    // sair dela equivale a sair do mapa.
+    const int32 NeighborOffsets[4] = { 1, -1, WindowX, -WindowX };
+
+    for (int32 Iter = 0; Iter < NumIterations; ++Iter)
+    {
+        // 1. Chuva local
+        for (int32 i : Affected)
+        {
+            Water[i] += RainAmount;
+        }
+
+        // 2. Espalhamento da água (escorrimento)
+        for (int32 i : Affected)
+        {
+            const int32 X = i % WindowX;
+            const int32 Y = i / WindowX;
+            const bool bHasNeighbor[4] = { X + 1 < WindowX, X > 0, Y + 1 < WindowY, Y > 0 };
+
+            const float CurrentGround = Ground[i];
+            const float CurrentHeight = CurrentGround + Water[i];
+
+            float LowestHeight = CurrentHeight;
+            int32 LowestNeighbor = -1;
+
+            for (int32 n = 0; n < 4; ++n)
+            {
+                if (!bHasNeighbor[n])
+                    continue;
+
+                const int32 NeighborIndex = i + NeighborOffsets[n];
+                const float NeighborHeight = Ground[NeighborIndex] + Water[NeighborIndex];
+
+                if (NeighborHeight < LowestHeight)
+                {
+                    LowestHeight = NeighborHeight;
+                    LowestNeighbor = NeighborIndex;
+                }
+            }
+
+            // Move água se possível
+            if (LowestNeighbor != -1)
+            {
+                float FlowAmount = (CurrentHeight - LowestHeight) * 0.5f;
+                FlowAmount = FMath::Clamp(FlowAmount, 0.0f, Water[i]);
+
+                Water[i] -= FlowAmount;
+                Water[LowestNeighbor] += FlowAmount;
+
+                Erosion[i] += FlowAmount;
+
+                // Se água encontrar ponto muito fundo (canal do rio), amplifica erosão
+                if (Ground[LowestNeighbor] < CurrentGround - 50.0f)
+                {
+                    Erosion[i] += FlowAmount * 1.5f;
+                }
+            }
+        }
+    }
+
+    // 3. Aplica a erosão ao terreno
+    for (int32 i : Affected)
+    {
+        const int32 X = Window.Min.X + i % WindowX;
+        const int32 Y = Window.Min.Y + i / WindowX;
+
+        Heightfield.GetHeight(X, Y) -= Erosion[i] * ErosionStrength;
+        Dirty.Include(X, Y);
+    }
+
+    return Dirty;
+}
+
+bool FTerrainTiledErosion::Run(const FString& Path, int32 Halo, int32 NumPasses, TFunctionRef<void(FTerrainHeightfield&)> Kernel)
+{
+    Halo = FMath::Max(Halo, 0);
+
+    // A passada é gravada ao lado e só então substitui o arquivo (que fica
+    // mapeado para leitura enquanto isso)
+    const FString PassPath = Path + TEXT(".pass");
+
+    FTerrainHeightfieldFile Current;
+    FTerrainHeightfield Window;
+
+    for (int32 Pass = 0; Pass < NumPasses; ++Pass)
+    {
+        if (!Current.Open(Path)) return false;
+
+        const FIntPoint GridSize(Current.GetNumX(), Current.GetNumY());
+        bool bRead = true;
+
+        const bool bWritten = FTerrainHeightfieldFile::Write(PassPath, GridSize.X, GridSize.Y, Current.GetCellSize(), Current.GetTileSize(), [&](const FTerrainDirtyRegion& Tile, TArray<float>& OutHeights)
+        {
+            FTerrainDirtyRegion WindowRegion = Tile.ExpandBy(Halo);
+            WindowRegion.Min = WindowRegion.Min.ComponentMax(FIntPoint(0, 0));
+            WindowRegion.Max = WindowRegion.Max.ComponentMin(GridSize);
+
+            Window.NumX = WindowRegion.Max.X - WindowRegion.Min.X;
+            Window.NumY = WindowRegion.Max.Y - WindowRegion.Min.Y;
+            Window.CellSize = Current.GetCellSize();
+
+            if (!Current.ReadRegion(WindowRegion, Window.Heights))
+            {
+                bRead = false;
+                return;
+            }
+
+            Kernel(Window);
+
+            // Descarta o halo: só o miolo é gravado
+            const int32 TileWidth = Tile.Max.X - Tile.Min.X;
+
+            for (int32 Y = 0; Y < Tile.Max.Y - Tile.Min.Y; ++Y)
+            {
+                FMemory::Memcpy(
+                    &OutHeights[Y * TileWidth],
+                    &Window.Heights[Window.GetIndex(Tile.Min.X - WindowRegion.Min.X, Tile.Min.Y - WindowRegion.Min.Y + Y)],
+                    TileWidth * sizeof(float)
+                );
+            }
+        });
+
+        Current.Close();
+
+        if (!bWritten || !bRead)
+        {
+            IFileManager::Get().Delete(*PassPath, false, false, true);
+            return false;
+        }
+
+        if (!IFileManager::Get().Move(*Path, *PassPath, true, true)) return false;
+    }
+
+    return true;
+}
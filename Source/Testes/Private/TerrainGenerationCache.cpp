@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainGenerationCache.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+
+namespace TerrainGenerationCachePrivate
+{
+    constexpr uint32 Magic = 0x31434754; // "TGC1"
+
+    // Cabeçalho fixo; os blocos vêm em seguida, na ordem dos contadores
+    struct FHeader
+    {
+        uint32 Magic;
+        uint32 Version;
+        uint64 Key;
+        int32 NumX;
+        int32 NumY;
+        float CellSize;
+        int32 NumRiverPoints;
+        int32 NumWaterTransforms;
+        int32 Padding;
+    };
+
+    // Instância de água em float: 48 bytes (40 de dados; o FQuat4f é
+    // alinhado a 16, então sobram 8 de preenchimento no fim) contra os 96
+    // do FTransform em double
+    struct FPackedTransform
+    {
+        FQuat4f Rotation;
+        FVector3f Translation;
+        FVector3f Scale;
+    };
+
+    static_assert(sizeof(FPackedTransform) == 48, "O formato do arquivo depende do tamanho de FPackedTransform");
+
+    int64 GetPayloadSize(const FHeader& Header)
+    {
+        const int64 NumVertices = (int64)Header.NumX * Header.NumY;
+        return NumVertices * sizeof(float)
+            + (int64)Header.NumRiverPoints * sizeof(FVector2D)
+            + (int64)Header.NumWaterTransforms * sizeof(FPackedTransform);
+    }
+}
+
+FTerrainGenerationKey::FTerrainGenerationKey()
+{
+    Add(FTerrainGenerationCache::Version);
+}
+
+FString FTerrainGenerationCache::GetDirectory()
+{
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("TerrainCache"));
+}
+
+FString FTerrainGenerationCache::GetPath(uint64 Key)
+{
+    return FPaths::Combine(GetDirectory(), FString::Printf(TEXT("%016llx.terrain"), Key));
+}
+
+bool FTerrainGenerationCache::Load(uint64 Key, FTerrainHeightfield& OutHeightfield, TArray<FVector2D>& OutRiverPath, TArray<FTransform>& OutWaterTransforms)
+{
+    using namespace TerrainGenerationCachePrivate;
+
+    // Uma leitura só do arquivo inteiro; o resto é cópia de memória
+    TArray64<uint8> Data;
+    if (!FFileHelper::LoadFileToArray(Data, *GetPath(Key), FILEREAD_Silent)) return false;
+
+    if (Data.Num() < (int64)sizeof(FHeader)) return false;
+
+    FHeader Header;
+    FMemory::Memcpy(&Header, Data.GetData(), sizeof(FHeader));
+
+    if (Header.Magic != Magic || Header.Version != Version || Header.Key != Key ||
+        Header.NumX < 0 || Header.NumY < 0 || Header.NumRiverPoints < 0 || Header.NumWaterTransforms < 0 ||
+        Data.Num() != (int64)sizeof(FHeader) + GetPayloadSize(Header))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Cache de terreno inválido: %s"), *GetPath(Key));
+        return false;
+    }
+
+    const uint8* Cursor = Data.GetData() + sizeof(FHeader);
+    const int32 NumVertices = Header.NumX * Header.NumY;
+
+    OutHeightfield.Init(Header.NumX, Header.NumY, Header.CellSize);
+    FMemory::Memcpy(OutHeightfield.Heights.GetData(), Cursor, NumVertices * sizeof(float));
+    Cursor += NumVertices * sizeof(float);
+
+    OutRiverPath.SetNumUninitialized(Header.NumRiverPoints);
+    FMemory::Memcpy(OutRiverPath.GetData(), Cursor, Header.NumRiverPoints * sizeof(FVector2D));
+    Cursor += Header.NumRiverPoints * sizeof(FVector2D);
+
+    OutWaterTransforms.Reset(Header.NumWaterTransforms);
+
+    for (int32 i = 0; i < Header.NumWaterTransforms; ++i)
+    {
+        FPackedTransform Packed;
+        FMemory::Memcpy(&Packed, Cursor, sizeof(FPackedTransform));
+        Cursor += sizeof(FPackedTransform);
+
+        OutWaterTransforms.Add(FTransform(FQuat(Packed.Rotation), FVector(Packed.Translation), FVector(Packed.Scale)));
+    }
+
+    // Conta como uso recente para Trim
+    IFileManager::Get().SetTimeStamp(*GetPath(Key), FDateTime::UtcNow());
+    return true;
+}
+
+bool FTerrainGenerationCache::Save(uint64 Key, const FTerrainHeightfield& Heightfield, const TArray<FVector2D>& RiverPath, const TArray<FTransform>& WaterTransforms)
+{
+    using namespace TerrainGenerationCachePrivate;
+
+    FHeader Header;
+    FMemory::Memzero(Header);
+    Header.Magic = Magic;
+    Header.Version = Version;
+    Header.Key = Key;
+    Header.NumX = Heightfield.NumX;
+    Header.NumY = Heightfield.NumY;
+    Header.CellSize = Heightfield.CellSize;
+    Header.NumRiverPoints = RiverPath.Num();
+    Header.NumWaterTransforms = WaterTransforms.Num();
+
+    // Monta o arquivo em memória e grava de uma vez
+    TArray64<uint8> Data;
+    Data.Reserve(sizeof(FHeader) + GetPayloadSize(Header));
+    Data.Append((const uint8*)&Header, sizeof(FHeader));
+    Data.Append((const uint8*)Heightfield.Heights.GetData(), (int64)Heightfield.Num() * sizeof(float));
+    Data.Append((const uint8*)RiverPath.GetData(), (int64)RiverPath.Num() * sizeof(FVector2D));
+
+    for (const FTransform& Transform : WaterTransforms)
+    {
+        FPackedTransform Packed;
+        Packed.Rotation = FQuat4f(Transform.GetRotation());
+        Packed.Translation = FVector3f(Transform.GetTranslation());
+        Packed.Scale = FVector3f(Transform.GetScale3D());
+        Data.Append((const uint8*)&Packed, sizeof(FPackedTransform));
+    }
+
+    // Grava num temporário e renomeia: outro gerador lendo a mesma chave
+    // nunca vê um arquivo pela metade. O nome é único por gravação, então
+    // dois geradores salvando ao mesmo tempo não escrevem no mesmo arquivo.
+    const FString Path = GetPath(Key);
+    const FString TempPath = FString::Printf(TEXT("%s.%s.tmp"), *Path, *FGuid::NewGuid().ToString());
+
+    if (!FFileHelper::SaveArrayToFile(Data, *TempPath) ||
+        !IFileManager::Get().Move(*Path, *TempPath, true, true))
+    {
+        IFileManager::Get().Delete(*TempPath, false, false, true);
+        return false;
+    }
+
+    return true;
+}
+
+int32 FTerrainGenerationCache::Trim(int64 MaxBytes, uint64 KeepKey)
+{
+    struct FEntry
+    {
+        FString Path;
+        FDateTime LastUsed;
+        int64 Size;
+    };
+
+    TArray<FEntry> Entries;
+    int64 TotalBytes = 0;
+
+    // Só os .terrain: temporários de gravações em andamento ficam
+    IFileManager::Get().IterateDirectoryStat(*GetDirectory(), [&Entries, &TotalBytes](const TCHAR* Name, const FFileStatData& Stat)
+    {
+        if (!Stat.bIsDirectory && FPaths::GetExtension(Name) == TEXT("terrain"))
+        {
+            Entries.Add({ Name, Stat.ModificationTime, Stat.FileSize });
+            TotalBytes += Stat.FileSize;
+        }
+        return true;
+    });
+
+    if (TotalBytes <= MaxBytes) return 0;
+
+    // Usados há mais tempo primeiro
+    Entries.Sort([](const FEntry& A, const FEntry& B) { return A.LastUsed < B.LastUsed; });
+
+    const FString KeepName = FPaths::GetCleanFilename(GetPath(KeepKey));
+    int32 NumDeleted = 0;
+
+    for (const FEntry& Entry : Entries)
+    {
+        if (TotalBytes <= MaxBytes) break;
+        if (FPaths::GetCleanFilename(Entry.Path) == KeepName) continue;
+
+        if (IFileManager::Get().Delete(*Entry.Path, false, false, true))
+        {
+            TotalBytes -= Entry.Size;
+            ++NumDeleted;
+        }
+    }
+
+    return NumDeleted;
+}
+
+bool FTerrainGenerationCache::Clear()
+{
+    return IFileManager::Get().DeleteDirectory(*GetDirectory(), false, true);
+}
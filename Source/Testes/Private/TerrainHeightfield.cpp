@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainHeightfield.h"
+
+void FTerrainHeightfield::Init(int32 InNumX, int32 InNumY, float InCellSize)
+{
+    NumX = FMath::Max(InNumX, 0);
+    NumY = FMath::Max(InNumY, 0);
+    CellSize = InCellSize;
+    Heights.Init(0.0f, NumX * NumY);
+}
+
+FTerrainDirtyRegion FTerrainHeightfield::GetRegionInBox(const FVector2D& BoxMin, const FVector2D& BoxMax) const
+{
+    FTerrainDirtyRegion Region;
+
+    if (IsEmpty() || CellSize <= 0.0f) return Region;
+
+    Region.Min.X = FMath::Max(FMath::CeilToInt(BoxMin.X / CellSize), 0);
+    Region.Min.Y = FMath::Max(FMath::CeilToInt(BoxMin.Y / CellSize), 0);
+    Region.Max.X = FMath::Min(FMath::FloorToInt(BoxMax.X / CellSize) + 1, NumX);
+    Region.Max.Y = FMath::Min(FMath::FloorToInt(BoxMax.Y / CellSize) + 1, NumY);
+    return Region;
+}
+
+FTerrainDirtyRegion FTerrainHeightfield::GetRegionInRadius(const FVector2D& Center, float Radius) const
+{
+    if (Radius < 0.0f) return FTerrainDirtyRegion();
+
+    return GetRegionInBox(Center - FVector2D(Radius, Radius), Center + FVector2D(Radius, Radius));
+}
+
+FTerrainDirtyRegion FTerrainHeightfield::RaiseInRadius(const FVector2D& Center, float Radius, float DeltaHeight)
+{
+    const FTerrainDirtyRegion Bounds = GetRegionInRadius(Center, Radius);
+    FTerrainDirtyRegion Dirty;
+
+    if (Bounds.IsEmpty() || Radius <= 0.0f) return Dirty;
+
+    const float RadiusSq = Radius * Radius;
+
+    for (int32 Y = Bounds.Min.Y; Y < Bounds.Max.Y; ++Y)
+    {
+        for (int32 X = Bounds.Min.X; X < Bounds.Max.X; ++X)
+        {
+            const float DistSq = FVector2D::DistSquared(GetLocation2D(X, Y), Center);
+
+            if (DistSq <= RadiusSq)
+            {
+                float Dist = FMath::Sqrt(DistSq);
+
+                // Suavemente afeta os vértices com base na distância
+                float Falloff = 1.0f - (Dist / Radius);
+                GetHeight(X, Y) += DeltaHeight * Falloff;
+                Dirty.Include(X, Y);
+            }
+        }
+    }
+
+    return Dirty;
+}
+
+FTerrainDirtyRegion FTerrainHeightfield::LevelInRadius(const FVector2D& Center, float Radius, float TargetHeight)
+{
+    const FTerrainDirtyRegion Bounds = GetRegionInRadius(Center, Radius);
+    FTerrainDirtyRegion Dirty;
+
+    if (Bounds.IsEmpty() || Radius <= 0.0f) return Dirty;
+
+    const float RadiusSq = Radius * Radius;
+
+    for (int32 Y = Bounds.Min.Y; Y < Bounds.Max.Y; ++Y)
+    {
+        for (int32 X = Bounds.Min.X; X < Bounds.Max.X; ++X)
+        {
+            const float DistSq = FVector2D::DistSquared(GetLocation2D(X, Y), Center);
+
+            if (DistSq <= RadiusSq)
+            {
+                float Dist = FMath::Sqrt(DistSq);
+
+                // Interpola a altura atual até o valor desejado, com falloff
+                float Falloff = 1.0f - (Dist / Radius);
+                float& Height = GetHeight(X, Y);
+                Height = FMath::Lerp(Height, TargetHeight, Falloff);
+                Dirty.Include(X, Y);
+            }
+        }
+    }
+
+    return Dirty;
+}
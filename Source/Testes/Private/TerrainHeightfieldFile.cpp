@@ -0,0 +1,298 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainHeightfieldFile.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+
+namespace TerrainHeightfieldFilePrivate
+{
+    constexpr uint32 Magic = 0x31464854; // "THF1"
+    constexpr uint32 Version = 1;
+
+    // Tiles alinhados à página: mapear/ler um tile não puxa o vizinho
+    constexpr uint64 TileAlignment = 4096;
+
+    struct FHeader
+    {
+        uint32 Magic;
+        uint32 Version;
+        int32 NumX;
+        int32 NumY;
+        float CellSize;
+        int32 TileSize;
+        int32 NumTilesX;
+        int32 NumTilesY;
+        uint64 TileDataOffset;
+    };
+
+    int64 GetTileBytes(int32 TileSize)
+    {
+        return (int64)TileSize * TileSize * sizeof(uint16);
+    }
+
+    uint64 GetTileDataOffset(int64 NumTiles, int32 EntrySize)
+    {
+        return Align((uint64)sizeof(FHeader) + (uint64)NumTiles * EntrySize, TileAlignment);
+    }
+}
+
+FTerrainHeightfieldFile::FTerrainHeightfieldFile() = default;
+
+FTerrainHeightfieldFile::~FTerrainHeightfieldFile()
+{
+    Close();
+}
+
+bool FTerrainHeightfieldFile::Write(const FString& Path, int32 InNumX, int32 InNumY, float InCellSize, int32 InTileSize, TFunctionRef<void(const FTerrainDirtyRegion&, TArray<float>&)> FillTile)
+{
+    using namespace TerrainHeightfieldFilePrivate;
+
+    if (InNumX <= 0 || InNumY <= 0 || InTileSize <= 0) return false;
+
+    FHeader Header;
+    FMemory::Memzero(Header);
+    Header.Version = Version;
+    Header.NumX = InNumX;
+    Header.NumY = InNumY;
+    Header.CellSize = InCellSize;
+    Header.TileSize = InTileSize;
+    Header.NumTilesX = FMath::DivideAndRoundUp(InNumX, InTileSize);
+    Header.NumTilesY = FMath::DivideAndRoundUp(InNumY, InTileSize);
+
+    const int32 NumTiles = Header.NumTilesX * Header.NumTilesY;
+    Header.TileDataOffset = GetTileDataOffset(NumTiles, sizeof(FTileEntry));
+
+    TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Path));
+    if (!Writer) return false;
+
+    // Cabeçalho sem Magic e índice zerado por enquanto: um arquivo
+    // interrompido no meio nunca é aceito por Open
+    TArray<FTileEntry> Entries;
+    Entries.SetNumZeroed(NumTiles);
+
+    TArray<uint8> Prefix;
+    Prefix.SetNumZeroed(Header.TileDataOffset);
+    Writer->Serialize(Prefix.GetData(), Prefix.Num());
+
+    TArray<float> Heights;
+    TArray<uint16> Quantized;
+
+    for (int32 TileY = 0; TileY < Header.NumTilesY; ++TileY)
+    {
+        for (int32 TileX = 0; TileX < Header.NumTilesX; ++TileX)
+        {
+            FTerrainDirtyRegion Region;
+            Region.Min = FIntPoint(TileX * InTileSize, TileY * InTileSize);
+            Region.Max = FIntPoint(FMath::Min(Region.Min.X + InTileSize, InNumX), FMath::Min(Region.Min.Y + InTileSize, InNumY));
+
+            const int32 TileWidth = Region.Max.X - Region.Min.X;
+            const int32 TileHeight = Region.Max.Y - Region.Min.Y;
+
+            Heights.SetNumUninitialized(TileWidth * TileHeight);
+            FillTile(Region, Heights);
+
+            // Mínimo e escala por tile: a precisão acompanha o relevo local
+            float MinHeight = MAX_flt;
+            float MaxHeight = -MAX_flt;
+
+            for (float Height : Heights)
+            {
+                MinHeight = FMath::Min(MinHeight, Height);
+                MaxHeight = FMath::Max(MaxHeight, Height);
+            }
+
+            FTileEntry& Entry = Entries[TileY * Header.NumTilesX + TileX];
+            Entry.MinHeight = MinHeight;
+            Entry.Scale = (MaxHeight - MinHeight) / MAX_uint16;
+
+            const float InvScale = Entry.Scale > 0.0f ? 1.0f / Entry.Scale : 0.0f;
+
+            // Tile completo; o que passa da borda do mapa fica em zero
+            Quantized.Init(0, InTileSize * InTileSize);
+
+            for (int32 Y = 0; Y < TileHeight; ++Y)
+            {
+                for (int32 X = 0; X < TileWidth; ++X)
+                {
+                    const float Normalized = (Heights[Y * TileWidth + X] - MinHeight) * InvScale;
+                    Quantized[Y * InTileSize + X] = (uint16)FMath::Clamp(FMath::RoundToInt(Normalized), 0, (int32)MAX_uint16);
+                }
+            }
+
+            Writer->Serialize(Quantized.GetData(), GetTileBytes(InTileSize));
+        }
+    }
+
+    // Agora sim o índice e o cabeçalho completo
+    Header.Magic = Magic;
+    Writer->Seek(0);
+    Writer->Serialize(&Header, sizeof(FHeader));
+    Writer->Serialize(Entries.GetData(), (int64)Entries.Num() * sizeof(FTileEntry));
+
+    return Writer->Close();
+}
+
+bool FTerrainHeightfieldFile::Write(const FString& Path, const FTerrainHeightfield& Heightfield, int32 InTileSize)
+{
+    return Write(Path, Heightfield.NumX, Heightfield.NumY, Heightfield.CellSize, InTileSize, [&Heightfield](const FTerrainDirtyRegion& Region, TArray<float>& OutHeights)
+    {
+        const int32 RegionX = Region.Max.X - Region.Min.X;
+
+        for (int32 Y = Region.Min.Y; Y < Region.Max.Y; ++Y)
+        {
+            FMemory::Memcpy(&OutHeights[(Y - Region.Min.Y) * RegionX], &Heightfield.Heights[Heightfield.GetIndex(Region.Min.X, Y)], RegionX * sizeof(float));
+        }
+    });
+}
+
+bool FTerrainHeightfieldFile::Open(const FString& Path)
+{
+    using namespace TerrainHeightfieldFilePrivate;
+
+    Close();
+
+    MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+    if (!MappedFile)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Não foi possível mapear %s"), *Path);
+        return false;
+    }
+
+    const int64 FileSize = MappedFile->GetFileSize();
+    if (FileSize < (int64)sizeof(FHeader))
+    {
+        Close();
+        return false;
+    }
+
+    // Mapeia o arquivo inteiro; as páginas só são lidas quando acessadas
+    MappedRegion.Reset(MappedFile->MapRegion(0, FileSize));
+    if (!MappedRegion)
+    {
+        Close();
+        return false;
+    }
+
+    const uint8* Data = MappedRegion->GetMappedPtr();
+
+    FHeader Header;
+    FMemory::Memcpy(&Header, Data, sizeof(FHeader));
+
+    const int64 NumTiles = (int64)Header.NumTilesX * Header.NumTilesY;
+
+    if (Header.Magic != Magic || Header.Version != Version ||
+        Header.NumX <= 0 || Header.NumY <= 0 || Header.TileSize <= 0 ||
+        Header.NumTilesX != FMath::DivideAndRoundUp(Header.NumX, Header.TileSize) ||
+        Header.NumTilesY != FMath::DivideAndRoundUp(Header.NumY, Header.TileSize) ||
+        Header.TileDataOffset != GetTileDataOffset(NumTiles, sizeof(FTileEntry)) ||
+        FileSize < (int64)Header.TileDataOffset + NumTiles * GetTileBytes(Header.TileSize))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Arquivo de heightfield inválido: %s"), *Path);
+        Close();
+        return false;
+    }
+
+    NumX = Header.NumX;
+    NumY = Header.NumY;
+    CellSize = Header.CellSize;
+    TileSize = Header.TileSize;
+    NumTilesX = Header.NumTilesX;
+    NumTilesY = Header.NumTilesY;
+
+    Entries = reinterpret_cast<const FTileEntry*>(Data + sizeof(FHeader));
+    TileData = Data + Header.TileDataOffset;
+    return true;
+}
+
+void FTerrainHeightfieldFile::Close()
+{
+    // A região precisa ser desfeita antes do handle
+    MappedRegion.Reset();
+    MappedFile.Reset();
+
+    Entries = nullptr;
+    TileData = nullptr;
+    NumX = NumY = TileSize = NumTilesX = NumTilesY = 0;
+}
+
+FTerrainDirtyRegion FTerrainHeightfieldFile::GetTileRegion(int32 TileX, int32 TileY) const
+{
+    FTerrainDirtyRegion Region;
+    Region.Min = FIntPoint(TileX * TileSize, TileY * TileSize);
+    Region.Max = FIntPoint(FMath::Min(Region.Min.X + TileSize, NumX), FMath::Min(Region.Min.Y + TileSize, NumY));
+    return Region;
+}
+
+const uint16* FTerrainHeightfieldFile::GetTileData(int32 TileX, int32 TileY) const
+{
+    return reinterpret_cast<const uint16*>(TileData + (TileY * NumTilesX + TileX) * TerrainHeightfieldFilePrivate::GetTileBytes(TileSize));
+}
+
+bool FTerrainHeightfieldFile::ReadTile(int32 TileX, int32 TileY, TArray<float>& OutHeights) const
+{
+    if (!IsOpen() || TileX < 0 || TileX >= NumTilesX || TileY < 0 || TileY >= NumTilesY) return false;
+
+    return ReadRegion(GetTileRegion(TileX, TileY), OutHeights);
+}
+
+float FTerrainHeightfieldFile::GetHeight(int32 X, int32 Y) const
+{
+    if (!IsOpen() || X < 0 || X >= NumX || Y < 0 || Y >= NumY) return 0.0f;
+
+    const FTileEntry& Entry = GetEntry(X / TileSize, Y / TileSize);
+    const uint16* Tile = GetTileData(X / TileSize, Y / TileSize);
+    return Entry.MinHeight + Tile[(Y % TileSize) * TileSize + (X % TileSize)] * Entry.Scale;
+}
+
+bool FTerrainHeightfieldFile::ReadRegion(const FTerrainDirtyRegion& Region, TArray<float>& OutHeights) const
+{
+    if (!IsOpen() || Region.IsEmpty() ||
+        Region.Min.X < 0 || Region.Min.Y < 0 || Region.Max.X > NumX || Region.Max.Y > NumY)
+    {
+        return false;
+    }
+
+    const int32 RegionX = Region.Max.X - Region.Min.X;
+    const int32 RegionY = Region.Max.Y - Region.Min.Y;
+    OutHeights.SetNumUninitialized(RegionX * RegionY);
+
+    // Uma linha por tarefa, atravessando os tiles da região em X
+    ParallelFor(RegionY, [&](int32 Row)
+    {
+        const int32 Y = Region.Min.Y + Row;
+        const int32 TileY = Y / TileSize;
+        const int32 LocalY = Y - TileY * TileSize;
+        float* Out = &OutHeights[Row * RegionX];
+
+        for (int32 TileX = Region.Min.X / TileSize; TileX <= (Region.Max.X - 1) / TileSize; ++TileX)
+        {
+            const FTileEntry& Entry = GetEntry(TileX, TileY);
+            const uint16* Source = GetTileData(TileX, TileY) + LocalY * TileSize;
+
+            const int32 MinX = FMath::Max(TileX * TileSize, Region.Min.X);
+            const int32 MaxX = FMath::Min((TileX + 1) * TileSize, Region.Max.X);
+
+            for (int32 X = MinX; X < MaxX; ++X)
+            {
+                Out[X - Region.Min.X] = Entry.MinHeight + Source[X - TileX * TileSize] * Entry.Scale;
+            }
+        }
+    });
+
+    return true;
+}
+
+bool FTerrainHeightfieldFile::ReadAll(FTerrainHeightfield& OutHeightfield) const
+{
+    if (!IsOpen()) return false;
+
+    FTerrainDirtyRegion Region;
+    Region.Min = FIntPoint(0, 0);
+    Region.Max = FIntPoint(NumX, NumY);
+
+    OutHeightfield.Init(NumX, NumY, CellSize);
+    return ReadRegion(Region, OutHeightfield.Heights);
+}
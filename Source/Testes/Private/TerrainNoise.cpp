@@ -0,0 +1,365 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainNoise.h"
+#include "TerrainRandom.h"
+#include "Async/ParallelFor.h"
+
+namespace TerrainNoisePrivate
+{
+    // Gradientes 2D (cantos e eixos, mesmo conjunto do FMath::PerlinNoise2D)
+    static const float GradX[8] = { 1.0f, 1.0f, 0.0f, -1.0f, -1.0f, -1.0f, 0.0f, 1.0f };
+    static const float GradY[8] = { 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, -1.0f, -1.0f, -1.0f };
+
+    FORCEINLINE float SmoothCurve(float T)
+    {
+        return T * T * T * (T * (T * 6.0f - 15.0f) + 10.0f);
+    }
+
+    FORCEINLINE VectorRegister4Float SmoothCurve(const VectorRegister4Float& T)
+    {
+        VectorRegister4Float R = VectorMultiplyAdd(T, VectorSetFloat1(6.0f), VectorSetFloat1(-15.0f));
+        R = VectorMultiplyAdd(T, R, VectorSetFloat1(10.0f));
+        return VectorMultiply(VectorMultiply(VectorMultiply(T, T), T), R);
+    }
+
+    FORCEINLINE VectorRegister4Float Lerp(const VectorRegister4Float& A, const VectorRegister4Float& B, const VectorRegister4Float& Alpha)
+    {
+        return VectorMultiplyAdd(VectorSubtract(B, A), Alpha, A);
+    }
+
+    FORCEINLINE float SmoothCurveDerivative(float T)
+    {
+        return 30.0f * T * T * (T * (T - 2.0f) + 1.0f);
+    }
+
+    FORCEINLINE VectorRegister4Float SmoothCurveDerivative(const VectorRegister4Float& T)
+    {
+        const VectorRegister4Float R = VectorMultiplyAdd(T, VectorSubtract(T, VectorSetFloat1(2.0f)), VectorOne());
+        return VectorMultiply(VectorMultiply(VectorSetFloat1(30.0f), VectorMultiply(T, T)), R);
+    }
+
+    // Perlin 2D em [-1,1] para 4 amostras na mesma linha (Y escalar)
+    struct FPerlinKernel
+    {
+        // Célula da grade de cada amostra: posição fracionária e gradientes dos cantos
+        struct FCell
+        {
+            VectorRegister4Float Fx;
+            float Fy;
+            VectorRegister4Float G00X, G00Y, G10X, G10Y, G01X, G01Y, G11X, G11Y;
+        };
+
+        static FORCEINLINE void Setup(const uint8* P, const VectorRegister4Float& SampleX, float SampleY, FCell& Cell)
+        {
+            alignas(16) float Floors[4];
+            alignas(16) float G00X[4], G00Y[4], G10X[4], G10Y[4];
+            alignas(16) float G01X[4], G01Y[4], G11X[4], G11Y[4];
+
+            // Y é o mesmo para as 4 amostras: resolve a parte escalar uma vez
+            const float Yfl = FMath::FloorToFloat(SampleY);
+            const int32 Yi = (int32)Yfl & 255;
+            Cell.Fy = SampleY - Yfl;
+
+            const VectorRegister4Float Xfl = VectorFloor(SampleX);
+            VectorStoreAligned(Xfl, Floors);
+
+            // Hash e gradientes dos 4 cantos de cada amostra
+            for (int32 Lane = 0; Lane < 4; ++Lane)
+            {
+                const int32 Xi = (int32)Floors[Lane] & 255;
+                const int32 AA = P[Xi] + Yi;
+                const int32 BA = P[Xi + 1] + Yi;
+
+                const int32 H00 = P[AA] & 7;
+                const int32 H10 = P[BA] & 7;
+                const int32 H01 = P[AA + 1] & 7;
+                const int32 H11 = P[BA + 1] & 7;
+
+                G00X[Lane] = GradX[H00]; G00Y[Lane] = GradY[H00];
+                G10X[Lane] = GradX[H10]; G10Y[Lane] = GradY[H10];
+                G01X[Lane] = GradX[H01]; G01Y[Lane] = GradY[H01];
+                G11X[Lane] = GradX[H11]; G11Y[Lane] = GradY[H11];
+            }
+
+            Cell.Fx = VectorSubtract(SampleX, Xfl);
+            Cell.G00X = VectorLoadAligned(G00X); Cell.G00Y = VectorLoadAligned(G00Y);
+            Cell.G10X = VectorLoadAligned(G10X); Cell.G10Y = VectorLoadAligned(G10Y);
+            Cell.G01X = VectorLoadAligned(G01X); Cell.G01Y = VectorLoadAligned(G01Y);
+            Cell.G11X = VectorLoadAligned(G11X); Cell.G11Y = VectorLoadAligned(G11Y);
+        }
+
+        // Contribuição (produto escalar gradiente x distância) de cada canto
+        static FORCEINLINE void Corners(const FCell& Cell, VectorRegister4Float& N00, VectorRegister4Float& N10, VectorRegister4Float& N01, VectorRegister4Float& N11)
+        {
+            const VectorRegister4Float Fxm1 = VectorSubtract(Cell.Fx, VectorOne());
+            const VectorRegister4Float VFy = VectorSetFloat1(Cell.Fy);
+            const VectorRegister4Float VFym1 = VectorSetFloat1(Cell.Fy - 1.0f);
+
+            N00 = VectorMultiplyAdd(Cell.G00X, Cell.Fx, VectorMultiply(Cell.G00Y, VFy));
+            N10 = VectorMultiplyAdd(Cell.G10X, Fxm1, VectorMultiply(Cell.G10Y, VFy));
+            N01 = VectorMultiplyAdd(Cell.G01X, Cell.Fx, VectorMultiply(Cell.G01Y, VFym1));
+            N11 = VectorMultiplyAdd(Cell.G11X, Fxm1, VectorMultiply(Cell.G11Y, VFym1));
+        }
+
+        static FORCEINLINE VectorRegister4Float Evaluate(const uint8* P, const VectorRegister4Float& SampleX, float SampleY)
+        {
+            FCell Cell;
+            Setup(P, SampleX, SampleY, Cell);
+
+            VectorRegister4Float N00, N10, N01, N11;
+            Corners(Cell, N00, N10, N01, N11);
+
+            const VectorRegister4Float U = SmoothCurve(Cell.Fx);
+            const VectorRegister4Float V = VectorSetFloat1(SmoothCurve(Cell.Fy));
+
+            return Lerp(Lerp(N00, N10, U), Lerp(N01, N11, U), V);
+        }
+
+        // Valor e derivadas analíticas em X/Y (por unidade de SampleX/SampleY).
+        // Com K = N00 - N10 - N01 + N11:
+        //   n    = N00 + U (N10 - N00) + V (N01 - N00) + U V K
+        //   dn/dx = G.x interpolado + U' ((N10 - N00) + V K)
+        //   dn/dy = G.y interpolado + V' ((N01 - N00) + U K)
+        static FORCEINLINE VectorRegister4Float EvaluateWithDerivatives(const uint8* P, const VectorRegister4Float& SampleX, float SampleY, VectorRegister4Float& OutDX, VectorRegister4Float& OutDY)
+        {
+            FCell Cell;
+            Setup(P, SampleX, SampleY, Cell);
+
+            VectorRegister4Float N00, N10, N01, N11;
+            Corners(Cell, N00, N10, N01, N11);
+
+            const VectorRegister4Float U = SmoothCurve(Cell.Fx);
+            const VectorRegister4Float V = VectorSetFloat1(SmoothCurve(Cell.Fy));
+            const VectorRegister4Float DU = SmoothCurveDerivative(Cell.Fx);
+            const VectorRegister4Float DV = VectorSetFloat1(SmoothCurveDerivative(Cell.Fy));
+
+            const VectorRegister4Float K = VectorAdd(VectorSubtract(VectorSubtract(N00, N10), N01), N11);
+
+            const VectorRegister4Float GradientX = Lerp(Lerp(Cell.G00X, Cell.G10X, U), Lerp(Cell.G01X, Cell.G11X, U), V);
+            const VectorRegister4Float GradientY = Lerp(Lerp(Cell.G00Y, Cell.G10Y, U), Lerp(Cell.G01Y, Cell.G11Y, U), V);
+
+            OutDX = VectorMultiplyAdd(DU, VectorMultiplyAdd(V, K, VectorSubtract(N10, N00)), GradientX);
+            OutDY = VectorMultiplyAdd(DV, VectorMultiplyAdd(U, K, VectorSubtract(N01, N00)), GradientY);
+
+            return Lerp(Lerp(N00, N10, U), Lerp(N01, N11, U), V);
+        }
+    };
+}
+
+FTerrainNoise::FTerrainNoise(const FTerrainNoiseSettings& InSettings)
+    : Settings(InSettings)
+{
+    NumOctaves = FMath::Clamp(Settings.Octaves, 0, MaxOctaves);
+
+    float Frequency = 6.5f;
+    float Amplitude = 100.0f;
+    float MaxValue = 0.0f;
+
+    for (int32 i = 0; i < NumOctaves; ++i)
+    {
+        OctaveFrequencies[i] = Frequency / Settings.NoiseScale;
+        OctaveWeights[i] = Amplitude;
+
+        MaxValue += Amplitude;
+        Amplitude *= Settings.Persistence;
+        Frequency *= Settings.Lacunarity;
+    }
+
+    // (Noise * 0.5 + 0.5) * Amplitude / MaxValue = 0.5 + Noise * (0.5 * Amplitude / MaxValue)
+    for (int32 i = 0; i < NumOctaves; ++i)
+    {
+        OctaveWeights[i] = 0.5f * OctaveWeights[i] / MaxValue;
+    }
+
+    // Deslocamento de cada oitava dentro do período de 256 da grade, para
+    // que as oitavas não compartilhem a mesma origem
+    for (int32 i = 0; i < NumOctaves; ++i)
+    {
+        OctaveOffsetsX[i] = FTerrainRandom::FRand(Settings.Seed, i, 0, ETerrainRandomPurpose::NoiseOffset) * 256.0f;
+        OctaveOffsetsY[i] = FTerrainRandom::FRand(Settings.Seed, i, 1, ETerrainRandomPurpose::NoiseOffset) * 256.0f;
+    }
+
+    // Permutação de 256 valores embaralhada pela seed e repetida 2x
+    for (int32 i = 0; i < 256; ++i)
+    {
+        Permutation[i] = (uint8)i;
+    }
+
+    FTerrainRandomStream Stream(Settings.Seed, 0, 0, ETerrainRandomPurpose::NoisePermutation);
+    for (int32 i = 255; i > 0; --i)
+    {
+        Swap(Permutation[i], Permutation[Stream.GetUnsignedInt() % (uint32)(i + 1)]);
+    }
+
+    for (int32 i = 0; i < 256; ++i)
+    {
+        Permutation[i + 256] = Permutation[i];
+    }
+
+    // Escolhe uma vez a versão com o laço de oitavas desenrolado
+    using namespace TerrainNoisePrivate;
+
+    switch (NumOctaves)
+    {
+    case 1: SelectKernel<FPerlinKernel, 1>(); break;
+    case 2: SelectKernel<FPerlinKernel, 2>(); break;
+    case 3: SelectKernel<FPerlinKernel, 3>(); break;
+    case 4: SelectKernel<FPerlinKernel, 4>(); break;
+    case 5: SelectKernel<FPerlinKernel, 5>(); break;
+    case 6: SelectKernel<FPerlinKernel, 6>(); break;
+    case 7: SelectKernel<FPerlinKernel, 7>(); break;
+    case 8: SelectKernel<FPerlinKernel, 8>(); break;
+    default: SelectKernel<FPerlinKernel, 0>(); break;
+    }
+}
+
+template<typename KernelType, int32 FixedOctaves>
+void FTerrainNoise::SelectKernel()
+{
+    SampleRowFunc = &FTerrainNoise::SampleRowImpl<KernelType, FixedOctaves, false>;
+    SampleRowDerivativesFunc = &FTerrainNoise::SampleRowImpl<KernelType, FixedOctaves, true>;
+    SampleBlockFunc = &FTerrainNoise::SampleBlockImpl<KernelType, FixedOctaves, false>;
+}
+
+void FTerrainNoise::SampleRow(int32 StartX, int32 Y, int32 Count, float* OutValues) const
+{
+    (this->*SampleRowFunc)(StartX, Y, Count, OutValues, nullptr, nullptr);
+}
+
+void FTerrainNoise::SampleRowWithDerivatives(int32 StartX, int32 Y, int32 Count, float* OutValues, float* OutDX, float* OutDY) const
+{
+    (this->*SampleRowDerivativesFunc)(StartX, Y, Count, OutValues, OutDX, OutDY);
+}
+
+template<typename KernelType, int32 FixedOctaves, bool bDerivatives>
+void FTerrainNoise::SampleRowImpl(int32 StartX, int32 Y, int32 Count, float* OutValues, float* OutDX, float* OutDY) const
+{
+    alignas(16) float Xs[4];
+
+    int32 i = 0;
+    for (; i + 4 <= Count; i += 4)
+    {
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            Xs[Lane] = (float)(StartX + i + Lane);
+        }
+        SampleBlockImpl<KernelType, FixedOctaves, bDerivatives>(Xs, (float)Y, OutValues + i,
+            bDerivatives ? OutDX + i : nullptr, bDerivatives ? OutDY + i : nullptr);
+    }
+
+    // Sobra da linha: completa o bloco repetindo a última amostra
+    if (i < Count)
+    {
+        const int32 Remaining = Count - i;
+        alignas(16) float Block[4];
+        alignas(16) float BlockDX[4];
+        alignas(16) float BlockDY[4];
+
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            Xs[Lane] = (float)(StartX + i + FMath::Min(Lane, Remaining - 1));
+        }
+        SampleBlockImpl<KernelType, FixedOctaves, bDerivatives>(Xs, (float)Y, Block, BlockDX, BlockDY);
+        FMemory::Memcpy(OutValues + i, Block, Remaining * sizeof(float));
+
+        if (bDerivatives)
+        {
+            FMemory::Memcpy(OutDX + i, BlockDX, Remaining * sizeof(float));
+            FMemory::Memcpy(OutDY + i, BlockDY, Remaining * sizeof(float));
+        }
+    }
+}
+
+void FTerrainNoise::SampleGrid(int32 StartX, int32 StartY, int32 NumX, int32 NumY, float* OutValues) const
+{
+    SampleGridWithDerivatives(StartX, StartY, NumX, NumY, OutValues, nullptr, nullptr);
+}
+
+void FTerrainNoise::SampleGridWithDerivatives(int32 StartX, int32 StartY, int32 NumX, int32 NumY, float* OutValues, float* OutDX, float* OutDY) const
+{
+    if (NumX <= 0 || NumY <= 0) return;
+
+    const bool bDerivatives = OutDX && OutDY;
+
+    // ~16k amostras por faixa: suficiente para amortizar o agendamento e
+    // ainda gerar faixas de sobra para balancear entre os núcleos
+    const int32 RowsPerBand = FMath::Max(1, 16384 / NumX);
+    const int32 NumBands = FMath::DivideAndRoundUp(NumY, RowsPerBand);
+
+    ParallelFor(NumBands, [this, StartX, StartY, NumX, NumY, RowsPerBand, OutValues, OutDX, OutDY, bDerivatives](int32 Band)
+    {
+        const int32 FirstRow = Band * RowsPerBand;
+        const int32 LastRow = FMath::Min(FirstRow + RowsPerBand, NumY);
+
+        for (int32 Row = FirstRow; Row < LastRow; ++Row)
+        {
+            const int64 Offset = (int64)Row * NumX;
+
+            if (bDerivatives)
+            {
+                SampleRowWithDerivatives(StartX, StartY + Row, NumX, OutValues + Offset, OutDX + Offset, OutDY + Offset);
+            }
+            else
+            {
+                SampleRow(StartX, StartY + Row, NumX, OutValues + Offset);
+            }
+        }
+    });
+}
+
+float FTerrainNoise::Sample(float X, float Y) const
+{
+    alignas(16) float Xs[4] = { X, X, X, X };
+    alignas(16) float Block[4];
+
+    (this->*SampleBlockFunc)(Xs, Y, Block, nullptr, nullptr);
+    return Block[0];
+}
+
+template<typename KernelType, int32 FixedOctaves, bool bDerivatives>
+void FTerrainNoise::SampleBlockImpl(const float* X, float Y, float* OutValues, float* OutDX, float* OutDY) const
+{
+    // FixedOctaves == 0: quantidade só conhecida em tempo de execução
+    const int32 Count = FixedOctaves > 0 ? FixedOctaves : NumOctaves;
+
+    const uint8* P = Permutation.GetData();
+    const VectorRegister4Float PosX = VectorLoadAligned(X);
+    VectorRegister4Float Total = VectorSetFloat1(0.5f);
+    VectorRegister4Float TotalDX = VectorZero();
+    VectorRegister4Float TotalDY = VectorZero();
+
+    for (int32 Octave = 0; Octave < Count; ++Octave)
+    {
+        const float Frequency = OctaveFrequencies[Octave];
+        const float SampleY = Y * Frequency + OctaveOffsetsY[Octave];
+        const VectorRegister4Float SampleX = VectorMultiplyAdd(PosX, VectorSetFloat1(Frequency), VectorSetFloat1(OctaveOffsetsX[Octave]));
+        const VectorRegister4Float Weight = VectorSetFloat1(OctaveWeights[Octave]);
+
+        // Ruído em [-1,1], acumulado já com o peso normalizado da oitava
+        if (bDerivatives)
+        {
+            VectorRegister4Float DX, DY;
+            const VectorRegister4Float Noise = KernelType::EvaluateWithDerivatives(P, SampleX, SampleY, DX, DY);
+            Total = VectorMultiplyAdd(Noise, Weight, Total);
+
+            // Regra da cadeia: a oitava lê a posição multiplicada por Frequency
+            const VectorRegister4Float DerivativeWeight = VectorSetFloat1(OctaveWeights[Octave] * Frequency);
+            TotalDX = VectorMultiplyAdd(DX, DerivativeWeight, TotalDX);
+            TotalDY = VectorMultiplyAdd(DY, DerivativeWeight, TotalDY);
+        }
+        else
+        {
+            const VectorRegister4Float Noise = KernelType::Evaluate(P, SampleX, SampleY);
+            Total = VectorMultiplyAdd(Noise, Weight, Total);
+        }
+    }
+
+    VectorStore(Total, OutValues);
+
+    if (bDerivatives)
+    {
+        VectorStore(TotalDX, OutDX);
+        VectorStore(TotalDY, OutDY);
+    }
+}
@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainNoiseCache.h"
+#include "Async/ParallelFor.h"
+#include "Misc/ScopeLock.h"
+
+FTerrainNoiseTileCache& FTerrainNoiseTileCache::Get()
+{
+    static FTerrainNoiseTileCache Instance;
+    return Instance;
+}
+
+namespace
+{
+    int32 GetMaxTilesForBytes(int64 Bytes)
+    {
+        return (int32)FMath::Clamp<int64>(Bytes / FTerrainNoiseTileCache::TileBytes, 1, MAX_int32);
+    }
+}
+
+// Começa pequeno (o maior bloco pedido decide quanto cresce)
+FTerrainNoiseTileCache::FTerrainNoiseTileCache(int64 InMaxBytes)
+    : Tiles(FMath::Min(64, GetMaxTilesForBytes(InMaxBytes)))
+    , MaxBytes(FMath::Max(InMaxBytes, TileBytes))
+{
+}
+
+void FTerrainNoiseTileCache::SampleGrid(const FTerrainNoiseSettings& Settings, int32 StartX, int32 StartY, int32 NumX, int32 NumY, float* OutValues, float* OutDX, float* OutDY)
+{
+    if (NumX <= 0 || NumY <= 0) return;
+
+    const FIntPoint FirstTile(FMath::FloorToInt((float)StartX / TileSize), FMath::FloorToInt((float)StartY / TileSize));
+    const FIntPoint LastTile(FMath::FloorToInt((float)(StartX + NumX - 1) / TileSize), FMath::FloorToInt((float)(StartY + NumY - 1) / TileSize));
+    const int32 NumTilesX = LastTile.X - FirstTile.X + 1;
+    const int32 NumTiles = NumTilesX * (LastTile.Y - FirstTile.Y + 1);
+
+    // 1. Procura os tiles no cache (o ponteiro compartilhado mantém o tile
+    // vivo mesmo que ele seja despejado enquanto copiamos)
+    TArray<TSharedPtr<const FTile>> Found;
+    Found.SetNum(NumTiles);
+    TArray<int32> Missing;
+
+    {
+        FScopeLock Lock(&Mutex);
+        GrowToLocked(NumTiles);
+
+        for (int32 i = 0; i < NumTiles; ++i)
+        {
+            const FTileKey Key(Settings, FirstTile + FIntPoint(i % NumTilesX, i / NumTilesX));
+
+            if (const TSharedPtr<const FTile>* Tile = Tiles.FindAndTouch(Key))
+            {
+                Found[i] = *Tile;
+                ++Hits;
+            }
+            else
+            {
+                Missing.Add(i);
+                ++Misses;
+            }
+        }
+    }
+
+    // 2. Gera os que faltam, um tile por tarefa
+    if (Missing.Num() > 0)
+    {
+        const FTerrainNoise Noise(Settings);
+
+        ParallelFor(Missing.Num(), [&](int32 MissingIndex)
+        {
+            const int32 i = Missing[MissingIndex];
+            const FIntPoint Origin = (FirstTile + FIntPoint(i % NumTilesX, i / NumTilesX)) * TileSize;
+
+            TSharedPtr<FTile> Tile = MakeShared<FTile>();
+            Tile->Values.SetNumUninitialized(TileSize * TileSize);
+            Tile->DX.SetNumUninitialized(TileSize * TileSize);
+            Tile->DY.SetNumUninitialized(TileSize * TileSize);
+
+            for (int32 Row = 0; Row < TileSize; ++Row)
+            {
+                const int32 Offset = Row * TileSize;
+                Noise.SampleRowWithDerivatives(Origin.X, Origin.Y + Row, TileSize, &Tile->Values[Offset], &Tile->DX[Offset], &Tile->DY[Offset]);
+            }
+
+            Found[i] = Tile;
+        });
+
+        FScopeLock Lock(&Mutex);
+
+        for (int32 i : Missing)
+        {
+            Tiles.Add(FTileKey(Settings, FirstTile + FIntPoint(i % NumTilesX, i / NumTilesX)), Found[i]);
+        }
+    }
+
+    // 3. Copia a interseção de cada tile com o bloco pedido, linha a linha
+    ParallelFor(NumY, [&](int32 Row)
+    {
+        const int32 Y = StartY + Row;
+        const int32 TileY = FMath::FloorToInt((float)Y / TileSize);
+        const int32 LocalY = Y - TileY * TileSize;
+
+        for (int32 TileX = FirstTile.X; TileX <= LastTile.X; ++TileX)
+        {
+            const FTile& Tile = *Found[(TileY - FirstTile.Y) * NumTilesX + (TileX - FirstTile.X)];
+
+            const int32 MinX = FMath::Max(StartX, TileX * TileSize);
+            const int32 MaxX = FMath::Min(StartX + NumX, (TileX + 1) * TileSize);
+            const int32 Source = LocalY * TileSize + (MinX - TileX * TileSize);
+            const int64 Target = (int64)Row * NumX + (MinX - StartX);
+            const int32 Bytes = (MaxX - MinX) * sizeof(float);
+
+            FMemory::Memcpy(OutValues + Target, &Tile.Values[Source], Bytes);
+
+            if (OutDX && OutDY)
+            {
+                FMemory::Memcpy(OutDX + Target, &Tile.DX[Source], Bytes);
+                FMemory::Memcpy(OutDY + Target, &Tile.DY[Source], Bytes);
+            }
+        }
+    });
+}
+
+void FTerrainNoiseTileCache::SetMaxBytes(int64 InMaxBytes)
+{
+    FScopeLock Lock(&Mutex);
+    MaxBytes = FMath::Max(InMaxBytes, TileBytes);
+
+    const int32 MaxTiles = GetMaxTilesForBytes(MaxBytes);
+
+    if (Tiles.Max() > MaxTiles)
+    {
+        Tiles.Empty(MaxTiles);
+    }
+}
+
+int64 FTerrainNoiseTileCache::GetMaxBytes() const
+{
+    FScopeLock Lock(&Mutex);
+    return MaxBytes;
+}
+
+void FTerrainNoiseTileCache::GrowToLocked(int32 MinTiles)
+{
+    const int32 NewMax = FMath::Min(MinTiles, GetMaxTilesForBytes(MaxBytes));
+
+    if (NewMax > Tiles.Max())
+    {
+        Tiles.Empty(NewMax);
+    }
+}
+
+void FTerrainNoiseTileCache::Empty()
+{
+    FScopeLock Lock(&Mutex);
+    Tiles.Empty(Tiles.Max());
+    Hits = 0;
+    Misses = 0;
+}
+
+FTerrainNoiseCacheStats FTerrainNoiseTileCache::GetStats() const
+{
+    FScopeLock Lock(&Mutex);
+
+    FTerrainNoiseCacheStats Stats;
+    Stats.Hits = Hits;
+    Stats.Misses = Misses;
+    Stats.NumTiles = Tiles.Num();
+    Stats.MaxTiles = Tiles.Max();
+    Stats.NumBytes = Stats.NumTiles * TileBytes;
+    Stats.MaxBytes = MaxBytes;
+    return Stats;
+}
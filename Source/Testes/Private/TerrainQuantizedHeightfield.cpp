@@ -0,0 +1,467 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainQuantizedHeightfield.h"
+#include "Async/ParallelFor.h"
+#include "Misc/Compression.h"
+#include "Misc/ScopeLock.h"
+
+namespace TerrainQuantizedHeightfieldPrivate
+{
+    // Diferença para o vizinho da esquerda (ou de cima, no início da linha)
+    // em planos de bytes: relevo suave vira quase só zeros no plano alto
+    void DeltaEncode(const TArray<uint16>& Values, int32 Width, TArray<uint8>& OutBytes)
+    {
+        const int32 Num = Values.Num();
+        OutBytes.SetNumUninitialized(Num * 2);
+
+        for (int32 i = 0; i < Num; ++i)
+        {
+            const uint16 Previous = (i % Width) > 0 ? Values[i - 1] : (i >= Width ? Values[i - Width] : 0);
+            const uint16 Delta = (uint16)(Values[i] - Previous);
+            OutBytes[i] = (uint8)(Delta >> 8);
+            OutBytes[Num + i] = (uint8)(Delta & 0xFF);
+        }
+    }
+
+    void DeltaDecode(const TArray<uint8>& Bytes, int32 Width, TArray<uint16>& OutValues)
+    {
+        const int32 Num = Bytes.Num() / 2;
+        OutValues.SetNumUninitialized(Num);
+
+        for (int32 i = 0; i < Num; ++i)
+        {
+            const uint16 Delta = (uint16)((Bytes[i] << 8) | Bytes[Num + i]);
+            const uint16 Previous = (i % Width) > 0 ? OutValues[i - 1] : (i >= Width ? OutValues[i - Width] : 0);
+            OutValues[i] = (uint16)(Previous + Delta);
+        }
+    }
+}
+
+FTerrainQuantizationReport FTerrainQuantizedHeightfield::Encode(const FTerrainHeightfield& Source, int32 InChunkSize)
+{
+    if (Source.IsEmpty())
+    {
+        Reset();
+        return FTerrainQuantizationReport();
+    }
+
+    return Encode(Source.NumX, Source.NumY, Source.CellSize, InChunkSize, [&Source](const FTerrainDirtyRegion& Region, TArray<float>& OutHeights)
+    {
+        const int32 RegionX = Region.Max.X - Region.Min.X;
+
+        for (int32 Y = Region.Min.Y; Y < Region.Max.Y; ++Y)
+        {
+            FMemory::Memcpy(&OutHeights[(Y - Region.Min.Y) * RegionX], &Source.Heights[Source.GetIndex(Region.Min.X, Y)], RegionX * sizeof(float));
+        }
+    });
+}
+
+FTerrainQuantizationReport FTerrainQuantizedHeightfield::Encode(int32 InNumX, int32 InNumY, float InCellSize, int32 InChunkSize, TFunctionRef<void(const FTerrainDirtyRegion&, TArray<float>&)> ReadChunk)
+{
+    Reset();
+    if (InNumX <= 0 || InNumY <= 0) return FTerrainQuantizationReport();
+
+    NumX = InNumX;
+    NumY = InNumY;
+    CellSize = InCellSize;
+    ChunkSize = FMath::Max(InChunkSize, 1);
+    NumChunksX = FMath::DivideAndRoundUp(NumX, ChunkSize);
+    NumChunksY = FMath::DivideAndRoundUp(NumY, ChunkSize);
+
+    Chunks.SetNum(NumChunksX * NumChunksY);
+
+    ParallelFor(Chunks.Num(), [&](int32 ChunkIndex)
+    {
+        const FTerrainDirtyRegion Region = GetChunkRegion(ChunkIndex);
+
+        TArray<float> Heights;
+        Heights.SetNumUninitialized((Region.Max.X - Region.Min.X) * (Region.Max.Y - Region.Min.Y));
+        ReadChunk(Region, Heights);
+
+        EncodeChunk(ChunkIndex, Heights);
+    });
+
+    return GetReport();
+}
+
+FTerrainQuantizationReport FTerrainQuantizedHeightfield::GetReport() const
+{
+    FTerrainQuantizationReport Report;
+    if (IsEmpty()) return Report;
+
+    double SumSquared = 0.0;
+
+    for (const FChunk& Chunk : Chunks)
+    {
+        Report.MaxError = FMath::Max(Report.MaxError, Chunk.MaxError);
+        Report.MaxStep = FMath::Max(Report.MaxStep, Chunk.Scale);
+        SumSquared += Chunk.SumSquared;
+    }
+
+    const int64 NumVertices = (int64)NumX * NumY;
+    Report.RmsError = (float)FMath::Sqrt(SumSquared / NumVertices);
+    Report.QuantizedBytes = GetAllocatedSize();
+    Report.FloatBytes = NumVertices * sizeof(float);
+    return Report;
+}
+
+void FTerrainQuantizedHeightfield::Reset()
+{
+    Chunks.Empty();
+    NumX = NumY = NumChunksX = NumChunksY = 0;
+    NumCompressions = NumDecompressions = 0;
+    AccessClock = 0;
+}
+
+FTerrainDirtyRegion FTerrainQuantizedHeightfield::GetFullRegion() const
+{
+    FTerrainDirtyRegion Region;
+    Region.Min = FIntPoint(0, 0);
+    Region.Max = FIntPoint(NumX, NumY);
+    return Region;
+}
+
+FTerrainDirtyRegion FTerrainQuantizedHeightfield::GetRegionInBox(const FVector2D& BoxMin, const FVector2D& BoxMax) const
+{
+    FTerrainDirtyRegion Region;
+
+    if (IsEmpty() || CellSize <= 0.0f) return Region;
+
+    Region.Min.X = FMath::Max(FMath::CeilToInt(BoxMin.X / CellSize), 0);
+    Region.Min.Y = FMath::Max(FMath::CeilToInt(BoxMin.Y / CellSize), 0);
+    Region.Max.X = FMath::Min(FMath::FloorToInt(BoxMax.X / CellSize) + 1, NumX);
+    Region.Max.Y = FMath::Min(FMath::FloorToInt(BoxMax.Y / CellSize) + 1, NumY);
+    return Region;
+}
+
+FTerrainDirtyRegion FTerrainQuantizedHeightfield::GetRegionInRadius(const FVector2D& Center, float Radius) const
+{
+    if (Radius < 0.0f) return FTerrainDirtyRegion();
+
+    return GetRegionInBox(Center - FVector2D(Radius, Radius), Center + FVector2D(Radius, Radius));
+}
+
+float FTerrainQuantizedHeightfield::GetHeight(int32 X, int32 Y) const
+{
+    if (X < 0 || X >= NumX || Y < 0 || Y >= NumY) return 0.0f;
+
+    FTerrainDirtyRegion Region;
+    Region.Include(X, Y);
+    MakeResident(Region);
+
+    return Decode(X, Y);
+}
+
+FTerrainDirtyRegion FTerrainQuantizedHeightfield::GetChunkRegion(int32 ChunkIndex) const
+{
+    FTerrainDirtyRegion Region;
+    Region.Min = FIntPoint((ChunkIndex % NumChunksX) * ChunkSize, (ChunkIndex / NumChunksX) * ChunkSize);
+    Region.Max = FIntPoint(FMath::Min(Region.Min.X + ChunkSize, NumX), FMath::Min(Region.Min.Y + ChunkSize, NumY));
+    return Region;
+}
+
+int64 FTerrainQuantizedHeightfield::GetAllocatedSize() const
+{
+    int64 Size = Chunks.GetAllocatedSize();
+
+    for (const FChunk& Chunk : Chunks)
+    {
+        Size += Chunk.Values.GetAllocatedSize() + Chunk.Compressed.GetAllocatedSize();
+    }
+
+    return Size;
+}
+
+void FTerrainQuantizedHeightfield::EncodeChunk(int32 ChunkIndex, const TArray<float>& Heights)
+{
+    float MinHeight = MAX_flt;
+    float MaxHeight = -MAX_flt;
+
+    for (float Height : Heights)
+    {
+        MinHeight = FMath::Min(MinHeight, Height);
+        MaxHeight = FMath::Max(MaxHeight, Height);
+    }
+
+    FChunk& Chunk = Chunks[ChunkIndex];
+    const FTerrainDirtyRegion Region = GetChunkRegion(ChunkIndex);
+
+    // Recodificação cuja faixa ainda cabe na atual: mantém mínimo e escala,
+    // então os vértices não editados voltam com o mesmo valor e edições
+    // repetidas não acumulam erro
+    const bool bReencode = Chunk.Values.Num() == Heights.Num();
+    const bool bKeepScale = bReencode && MinHeight >= Chunk.MinHeight && MaxHeight <= Chunk.MinHeight + Chunk.Scale * MAX_uint16;
+
+    if (!bKeepScale)
+    {
+        Chunk.MinHeight = MinHeight;
+        Chunk.Scale = (MaxHeight - MinHeight) / MAX_uint16;
+    }
+
+    Chunk.Width = Region.Max.X - Region.Min.X;
+    Chunk.LastAccess = AccessClock;
+    Chunk.Compressed.Empty();
+    Chunk.Values.SetNumUninitialized(Heights.Num());
+
+    const float InvScale = Chunk.Scale > 0.0f ? 1.0f / Chunk.Scale : 0.0f;
+
+    float MaxError = 0.0f;
+    double SumSquared = 0.0;
+
+    for (int32 i = 0; i < Heights.Num(); ++i)
+    {
+        const uint16 Value = (uint16)FMath::Clamp(FMath::RoundToInt((Heights[i] - Chunk.MinHeight) * InvScale), 0, (int32)MAX_uint16);
+        Chunk.Values[i] = Value;
+
+        const float Delta = FMath::Abs(Chunk.MinHeight + Value * Chunk.Scale - Heights[i]);
+        MaxError = FMath::Max(MaxError, Delta);
+        SumSquared += (double)Delta * Delta;
+    }
+
+    // Heights de uma recodificação já vem quantizado fora da edição: o erro
+    // antigo desses vértices continua valendo. Com a escala mantida ele não
+    // cresce; com escala nova os dois erros podem se somar.
+    if (bKeepScale)
+    {
+        Chunk.MaxError = FMath::Max(Chunk.MaxError, MaxError);
+        Chunk.SumSquared = FMath::Max(Chunk.SumSquared, SumSquared);
+    }
+    else if (bReencode)
+    {
+        Chunk.MaxError += MaxError;
+        Chunk.SumSquared = FMath::Square(FMath::Sqrt(Chunk.SumSquared) + FMath::Sqrt(SumSquared));
+    }
+    else
+    {
+        Chunk.MaxError = MaxError;
+        Chunk.SumSquared = SumSquared;
+    }
+}
+
+void FTerrainQuantizedHeightfield::MakeResident(const FTerrainDirtyRegion& Region) const
+{
+    if (Region.IsEmpty()) return;
+
+    const int32 FirstChunkX = FMath::Max(Region.Min.X, 0) / ChunkSize;
+    const int32 FirstChunkY = FMath::Max(Region.Min.Y, 0) / ChunkSize;
+    const int32 LastChunkX = (FMath::Min(Region.Max.X, NumX) - 1) / ChunkSize;
+    const int32 LastChunkY = (FMath::Min(Region.Max.Y, NumY) - 1) / ChunkSize;
+
+    // Duas tarefas podem pedir o mesmo chunk frio: só uma descomprime
+    FScopeLock Lock(&ResidencyMutex);
+
+    for (int32 ChunkY = FirstChunkY; ChunkY <= LastChunkY; ++ChunkY)
+    {
+        for (int32 ChunkX = FirstChunkX; ChunkX <= LastChunkX; ++ChunkX)
+        {
+            const int32 ChunkIndex = ChunkY * NumChunksX + ChunkX;
+
+            if (Chunks[ChunkIndex].Compressed.Num() > 0)
+            {
+                DecompressChunk(ChunkIndex);
+            }
+
+            Chunks[ChunkIndex].LastAccess = AccessClock;
+        }
+    }
+}
+
+int64 FTerrainQuantizedHeightfield::CompressChunk(int32 ChunkIndex)
+{
+    FChunk& Chunk = Chunks[ChunkIndex];
+    if (Chunk.Compressed.Num() > 0 || Chunk.Values.Num() == 0) return 0;
+
+    TArray<uint8> Compressed;
+    if (!CompressValues(Chunk, Compressed)) return 0;
+
+    const int64 Saved = Chunk.Values.GetAllocatedSize() - Compressed.GetAllocatedSize();
+    Chunk.Compressed = MoveTemp(Compressed);
+    Chunk.Values.Empty();
+    ++NumCompressions;
+    return Saved;
+}
+
+bool FTerrainQuantizedHeightfield::CompressValues(const FChunk& Chunk, TArray<uint8>& OutCompressed) const
+{
+    TArray<uint8> Bytes;
+    TerrainQuantizedHeightfieldPrivate::DeltaEncode(Chunk.Values, Chunk.Width, Bytes);
+
+    int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Oodle, Bytes.Num());
+    OutCompressed.SetNumUninitialized(CompressedSize);
+
+    // Só compensa se ficar menor que os valores crus
+    if (!FCompression::CompressMemory(NAME_Oodle, OutCompressed.GetData(), CompressedSize, Bytes.GetData(), Bytes.Num()) ||
+        CompressedSize >= Chunk.Values.Num() * (int32)sizeof(uint16))
+    {
+        return false;
+    }
+
+    OutCompressed.SetNum(CompressedSize);
+    OutCompressed.Shrink();
+    return true;
+}
+
+void FTerrainQuantizedHeightfield::DecompressValues(int32 ChunkIndex, TArray<uint16>& OutValues) const
+{
+    const FChunk& Chunk = Chunks[ChunkIndex];
+
+    // Tamanho original = vértices do chunk * 2 bytes
+    const FTerrainDirtyRegion Region = GetChunkRegion(ChunkIndex);
+    const int32 NumBytes = (Region.Max.X - Region.Min.X) * (Region.Max.Y - Region.Min.Y) * sizeof(uint16);
+
+    TArray<uint8> Bytes;
+    Bytes.SetNumUninitialized(NumBytes);
+
+    verify(FCompression::UncompressMemory(NAME_Oodle, Bytes.GetData(), NumBytes, Chunk.Compressed.GetData(), Chunk.Compressed.Num()));
+
+    TerrainQuantizedHeightfieldPrivate::DeltaDecode(Bytes, Chunk.Width, OutValues);
+}
+
+void FTerrainQuantizedHeightfield::DecompressChunk(int32 ChunkIndex) const
+{
+    FChunk& Chunk = Chunks[ChunkIndex];
+    DecompressValues(ChunkIndex, Chunk.Values);
+    Chunk.Compressed.Empty();
+    ++NumDecompressions;
+}
+
+const TArray<uint16>& FTerrainQuantizedHeightfield::GetChunkValues(int32 ChunkIndex, TArray<uint16>& Scratch) const
+{
+    if (Chunks[ChunkIndex].Compressed.Num() == 0) return Chunks[ChunkIndex].Values;
+
+    DecompressValues(ChunkIndex, Scratch);
+    return Scratch;
+}
+
+FIntPoint FTerrainQuantizedHeightfield::DecodeWindow(const FTerrainDirtyRegion& Region, FTerrainHeightfield& OutWindow, ETerrainChunkAccess Access) const
+{
+    FTerrainDirtyRegion Clamped = Region;
+    Clamped.Min = Clamped.Min.ComponentMax(FIntPoint(0, 0));
+    Clamped.Max = Clamped.Max.ComponentMin(FIntPoint(NumX, NumY));
+
+    if (Clamped.IsEmpty())
+    {
+        OutWindow.Init(0, 0, CellSize);
+        return FIntPoint(0, 0);
+    }
+
+    const int32 WindowX = Clamped.Max.X - Clamped.Min.X;
+    const int32 WindowY = Clamped.Max.Y - Clamped.Min.Y;
+    OutWindow.Init(WindowX, WindowY, CellSize);
+
+    if (Access == ETerrainChunkAccess::Streaming)
+    {
+        // Um chunk por tarefa; um chunk frio é descomprimido só na cópia da
+        // tarefa, então o pico é um chunk cru por thread
+        const FIntPoint FirstChunk(Clamped.Min.X / ChunkSize, Clamped.Min.Y / ChunkSize);
+        const FIntPoint LastChunk((Clamped.Max.X - 1) / ChunkSize, (Clamped.Max.Y - 1) / ChunkSize);
+        const int32 NumWindowChunksX = LastChunk.X - FirstChunk.X + 1;
+
+        ParallelFor(NumWindowChunksX * (LastChunk.Y - FirstChunk.Y + 1), [&](int32 i)
+        {
+            const int32 ChunkIndex = (FirstChunk.Y + i / NumWindowChunksX) * NumChunksX + FirstChunk.X + i % NumWindowChunksX;
+            const FChunk& Chunk = Chunks[ChunkIndex];
+            const FTerrainDirtyRegion ChunkRegion = GetChunkRegion(ChunkIndex);
+
+            TArray<uint16> Scratch;
+            const TArray<uint16>& Values = GetChunkValues(ChunkIndex, Scratch);
+
+            for (int32 Y = FMath::Max(ChunkRegion.Min.Y, Clamped.Min.Y); Y < FMath::Min(ChunkRegion.Max.Y, Clamped.Max.Y); ++Y)
+            {
+                for (int32 X = FMath::Max(ChunkRegion.Min.X, Clamped.Min.X); X < FMath::Min(ChunkRegion.Max.X, Clamped.Max.X); ++X)
+                {
+                    OutWindow.Heights[(Y - Clamped.Min.Y) * WindowX + (X - Clamped.Min.X)] =
+                        Chunk.MinHeight + Values[(Y - ChunkRegion.Min.Y) * Chunk.Width + (X - ChunkRegion.Min.X)] * Chunk.Scale;
+                }
+            }
+        });
+
+        return Clamped.Min;
+    }
+
+    MakeResident(Clamped);
+
+    // Janelas grandes (passes no mapa inteiro) em paralelo por linha
+    ParallelFor(WindowY, [&](int32 Row)
+    {
+        float* Target = &OutWindow.Heights[Row * WindowX];
+
+        for (int32 X = 0; X < WindowX; ++X)
+        {
+            Target[X] = Decode(Clamped.Min.X + X, Clamped.Min.Y + Row);
+        }
+    }, WindowX * WindowY < 16384 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+    return Clamped.Min;
+}
+
+void FTerrainQuantizedHeightfield::EncodeWindow(const FTerrainHeightfield& Window, const FIntPoint& Origin, const FTerrainDirtyRegion& Dirty, ETerrainChunkAccess Access)
+{
+    if (Dirty.IsEmpty() || IsEmpty()) return;
+
+    const int32 FirstChunkX = FMath::Max(Dirty.Min.X, 0) / ChunkSize;
+    const int32 FirstChunkY = FMath::Max(Dirty.Min.Y, 0) / ChunkSize;
+    const int32 LastChunkX = (FMath::Min(Dirty.Max.X, NumX) - 1) / ChunkSize;
+    const int32 LastChunkY = (FMath::Min(Dirty.Max.Y, NumY) - 1) / ChunkSize;
+
+    if (LastChunkX < FirstChunkX || LastChunkY < FirstChunkY) return;
+
+    const bool bStreaming = Access == ETerrainChunkAccess::Streaming;
+
+    // Os chunks podem ter partes fora da janela, lidas do valor atual
+    if (!bStreaming)
+    {
+        MakeResident(Dirty);
+    }
+
+    const int32 NumDirtyX = LastChunkX - FirstChunkX + 1;
+
+    ParallelFor(NumDirtyX * (LastChunkY - FirstChunkY + 1), [&](int32 i)
+    {
+        const int32 ChunkIndex = (FirstChunkY + i / NumDirtyX) * NumChunksX + FirstChunkX + i % NumDirtyX;
+        const FTerrainDirtyRegion Region = GetChunkRegion(ChunkIndex);
+        const int32 RegionX = Region.Max.X - Region.Min.X;
+
+        // Streaming: o chunk frio fica cru só durante esta tarefa
+        FChunk& Chunk = Chunks[ChunkIndex];
+        const bool bCold = Chunk.Compressed.Num() > 0;
+        const uint32 LastAccess = Chunk.LastAccess;
+
+        if (bCold)
+        {
+            DecompressValues(ChunkIndex, Chunk.Values);
+        }
+
+        // O chunk inteiro: da janela onde ela cobre, do valor atual fora dela
+        TArray<float> Heights;
+        Heights.SetNumUninitialized(RegionX * (Region.Max.Y - Region.Min.Y));
+
+        for (int32 Y = Region.Min.Y; Y < Region.Max.Y; ++Y)
+        {
+            for (int32 X = Region.Min.X; X < Region.Max.X; ++X)
+            {
+                const int32 WindowX = X - Origin.X;
+                const int32 WindowY = Y - Origin.Y;
+
+                Heights[(Y - Region.Min.Y) * RegionX + (X - Region.Min.X)] = Window.IsValid(WindowX, WindowY)
+                    ? Window.GetHeight(WindowX, WindowY)
+                    : Decode(X, Y);
+            }
+        }
+
+        EncodeChunk(ChunkIndex, Heights);
+
+        if (bStreaming)
+        {
+            Chunk.LastAccess = LastAccess;
+
+            TArray<uint8> Compressed;
+            if (bCold && CompressValues(Chunk, Compressed))
+            {
+                Chunk.Compressed = MoveTemp(Compressed);
+                Chunk.Values.Empty();
+            }
+        }
+    });
+}
@@ -0,0 +1,215 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainRiverNetwork.h"
+
+FTerrainRiverNetwork::FTerrainRiverNetwork(float InCellSize)
+    : CellSize(FMath::Max(InCellSize, 1.0f))
+{
+}
+
+void FTerrainRiverNetwork::Reset()
+{
+    Paths.Reset();
+    Segments.Reset();
+    RebuildIndex();
+}
+
+int32 FTerrainRiverNetwork::AddPath(const TArray<FVector2D>& Path)
+{
+    const int32 PathIndex = Paths.Add(Path);
+
+    for (int32 i = 0; i < Path.Num() - 1; ++i)
+    {
+        FTerrainRiverSegment& Segment = Segments.AddDefaulted_GetRef();
+        Segment.Start = Path[i];
+        Segment.End = Path[i + 1];
+        Segment.PathIndex = PathIndex;
+        Segment.PointIndex = i;
+    }
+
+    RebuildIndex();
+    return PathIndex;
+}
+
+FIntPoint FTerrainRiverNetwork::GetCell(const FVector2D& Point) const
+{
+    return FIntPoint(FMath::FloorToInt(Point.X / CellSize), FMath::FloorToInt(Point.Y / CellSize));
+}
+
+void FTerrainRiverNetwork::RebuildIndex()
+{
+    CellStart.Reset();
+    CellSegments.Reset();
+    NumCellsX = 0;
+    NumCellsY = 0;
+
+    if (Segments.Num() == 0) return;
+
+    FIntPoint MinCell(MAX_int32, MAX_int32);
+    FIntPoint MaxCell(MIN_int32, MIN_int32);
+
+    for (const FTerrainRiverSegment& Segment : Segments)
+    {
+        MinCell = MinCell.ComponentMin(GetCell(Segment.Start.ComponentMin(Segment.End)));
+        MaxCell = MaxCell.ComponentMax(GetCell(Segment.Start.ComponentMax(Segment.End)));
+    }
+
+    GridOrigin = MinCell;
+    NumCellsX = MaxCell.X - MinCell.X + 1;
+    NumCellsY = MaxCell.Y - MinCell.Y + 1;
+
+    // Cada segmento entra em todas as células da sua caixa
+    auto ForEachSegmentCell = [this](const FTerrainRiverSegment& Segment, TFunctionRef<void(int32)> Visit)
+    {
+        const FIntPoint First = GetCell(Segment.Start.ComponentMin(Segment.End)) - GridOrigin;
+        const FIntPoint Last = GetCell(Segment.Start.ComponentMax(Segment.End)) - GridOrigin;
+
+        for (int32 Y = First.Y; Y <= Last.Y; ++Y)
+        {
+            for (int32 X = First.X; X <= Last.X; ++X)
+            {
+                Visit(Y * NumCellsX + X);
+            }
+        }
+    };
+
+    CellStart.Init(0, NumCellsX * NumCellsY + 1);
+
+    for (const FTerrainRiverSegment& Segment : Segments)
+    {
+        ForEachSegmentCell(Segment, [this](int32 Cell) { ++CellStart[Cell + 1]; });
+    }
+
+    for (int32 Cell = 0; Cell < NumCellsX * NumCellsY; ++Cell)
+    {
+        CellStart[Cell + 1] += CellStart[Cell];
+    }
+
+    TArray<int32> Cursor(CellStart.GetData(), NumCellsX * NumCellsY);
+    CellSegments.SetNumUninitialized(CellStart.Last());
+
+    for (int32 SegmentIndex = 0; SegmentIndex < Segments.Num(); ++SegmentIndex)
+    {
+        ForEachSegmentCell(Segments[SegmentIndex], [this, &Cursor, SegmentIndex](int32 Cell)
+        {
+            CellSegments[Cursor[Cell]++] = SegmentIndex;
+        });
+    }
+}
+
+void FTerrainRiverNetwork::TestCell(int32 CellX, int32 CellY, const FVector2D& Point, FTerrainRiverHit& InOutHit) const
+{
+    if (CellX < 0 || CellX >= NumCellsX || CellY < 0 || CellY >= NumCellsY) return;
+
+    const int32 Cell = CellY * NumCellsX + CellX;
+
+    for (int32 i = CellStart[Cell]; i < CellStart[Cell + 1]; ++i)
+    {
+        const FTerrainRiverSegment& Segment = Segments[CellSegments[i]];
+        const FVector2D Closest = FMath::ClosestPointOnSegment2D(Point, Segment.Start, Segment.End);
+        const float Distance = FVector2D::Distance(Point, Closest);
+
+        if (Distance < InOutHit.Distance)
+        {
+            InOutHit.SegmentIndex = CellSegments[i];
+            InOutHit.ClosestPoint = Closest;
+            InOutHit.Distance = Distance;
+        }
+    }
+}
+
+FTerrainRiverHit FTerrainRiverNetwork::FindNearest(const FVector2D& Point) const
+{
+    FTerrainRiverHit Hit;
+
+    if (NumCellsX == 0 || NumCellsY == 0) return Hit;
+
+    const FIntPoint Cell = GetCell(Point) - GridOrigin;
+
+    // Anel inicial: distância (em células) de Point até a grade
+    const int32 OutsideX = Cell.X < 0 ? -Cell.X : FMath::Max(Cell.X - (NumCellsX - 1), 0);
+    const int32 OutsideY = Cell.Y < 0 ? -Cell.Y : FMath::Max(Cell.Y - (NumCellsY - 1), 0);
+    const int32 FirstRing = FMath::Max(OutsideX, OutsideY);
+    const int32 LastRing = FMath::Max(
+        FMath::Max(FMath::Abs(Cell.X), FMath::Abs(Cell.X - (NumCellsX - 1))),
+        FMath::Max(FMath::Abs(Cell.Y), FMath::Abs(Cell.Y - (NumCellsY - 1)))
+    );
+
+    for (int32 Ring = FirstRing; Ring <= LastRing; ++Ring)
+    {
+        // Nenhuma célula deste anel está a menos de (Ring - 1) células de Point
+        if (Hit.IsValid() && Hit.Distance <= (Ring - 1) * CellSize) break;
+
+        if (Ring == 0)
+        {
+            TestCell(Cell.X, Cell.Y, Point, Hit);
+            continue;
+        }
+
+        const int32 MinX = FMath::Max(Cell.X - Ring, 0);
+        const int32 MaxX = FMath::Min(Cell.X + Ring, NumCellsX - 1);
+        const int32 MinY = FMath::Max(Cell.Y - Ring + 1, 0);
+        const int32 MaxY = FMath::Min(Cell.Y + Ring - 1, NumCellsY - 1);
+
+        for (int32 X = MinX; X <= MaxX; ++X)
+        {
+            TestCell(X, Cell.Y - Ring, Point, Hit);
+            TestCell(X, Cell.Y + Ring, Point, Hit);
+        }
+
+        for (int32 Y = MinY; Y <= MaxY; ++Y)
+        {
+            TestCell(Cell.X - Ring, Y, Point, Hit);
+            TestCell(Cell.X + Ring, Y, Point, Hit);
+        }
+    }
+
+    return Hit;
+}
+
+float FTerrainRiverNetwork::GetDistanceToRiver(const FVector2D& Point) const
+{
+    return FindNearest(Point).Distance;
+}
+
+void FTerrainRiverNetwork::FindSegmentsInRadius(const FVector2D& Point, float Radius, TArray<int32>& OutSegments) const
+{
+    OutSegments.Reset();
+
+    if (NumCellsX == 0 || NumCellsY == 0 || Radius < 0.0f) return;
+
+    const FIntPoint First = GetCell(Point - FVector2D(Radius, Radius)) - GridOrigin;
+    const FIntPoint Last = GetCell(Point + FVector2D(Radius, Radius)) - GridOrigin;
+
+    for (int32 Y = FMath::Max(First.Y, 0); Y <= FMath::Min(Last.Y, NumCellsY - 1); ++Y)
+    {
+        for (int32 X = FMath::Max(First.X, 0); X <= FMath::Min(Last.X, NumCellsX - 1); ++X)
+        {
+            const int32 Cell = Y * NumCellsX + X;
+
+            for (int32 i = CellStart[Cell]; i < CellStart[Cell + 1]; ++i)
+            {
+                const FTerrainRiverSegment& Segment = Segments[CellSegments[i]];
+                const FVector2D Closest = FMath::ClosestPointOnSegment2D(Point, Segment.Start, Segment.End);
+
+                if (FVector2D::DistSquared(Point, Closest) <= Radius * Radius)
+                {
+                    OutSegments.Add(CellSegments[i]);
+                }
+            }
+        }
+    }
+
+    // Um segmento pode estar em várias células
+    OutSegments.Sort();
+    int32 NumUnique = 0;
+    for (int32 i = 0; i < OutSegments.Num(); ++i)
+    {
+        if (i == 0 || OutSegments[i] != OutSegments[i - 1])
+        {
+            OutSegments[NumUnique++] = OutSegments[i];
+        }
+    }
+    OutSegments.SetNum(NumUnique);
+}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "TerrainNoise.h"
 #include "PerlinMapGenerator.generated.h"
 
 UCLASS()
@@ -47,6 +48,10 @@ public:
     UPROPERTY(EditAnywhere, Category = "Noise Settings")
     int32 Seed = 1337;
 
+    // Declive máximo (graus) em que ainda nascem árvores; 90 = sem limite
+    UPROPERTY(EditAnywhere, Category = "Map Settings", meta = (ClampMin = "0", ClampMax = "90"))
+    float MaxTreeSlopeAngle = 90.0f;
+
     UPROPERTY(EditAnywhere, Category = "Mesh")
     UStaticMesh* CubeMesh;
 
@@ -82,5 +87,5 @@ private:
     UInstancedStaticMeshComponent* InstancedMeshComp;
 
     void GenerateMap();
-    float GeneratePerlinNoise(float X, float Y, FRandomStream& RandStream);
+    FTerrainNoiseSettings GetNoiseSettings() const;
 };
@@ -4,9 +4,42 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "TerrainChunkResidency.h"
+#include "TerrainChunks.h"
+#include "TerrainErosion.h"
+#include "TerrainHeightfield.h"
+#include "TerrainNoise.h"
+#include "TerrainQuantizedHeightfield.h"
+#include "TerrainRiverNetwork.h"
 #include "ProceduralMeshComponent.h"
 #include "PerlinMapProceduralMeshGenerator.generated.h"
 
+class FTerrainHeightfieldFile;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnTerrainGenerated);
+
+// Parâmetros copiados do ator para a geração fora da game thread
+struct FTerrainGenerationParams
+{
+    int32 MapWidth = 0;
+    int32 MapHeight = 0;
+    float HeightMultiplier = 0.0f;
+    int32 ChunkSize = 64;
+    FTerrainNoiseSettings NoiseSettings;
+    bool bUseGenerationCache = false;
+    int64 GenerationCacheMaxBytes = 0;
+};
+
+// Buffer de staging preenchido pela geração e consumido no commit
+struct FTerrainGenerationResult
+{
+    FTerrainHeightfield Heightfield;
+    FTerrainChunkGrid Chunks;
+    TArray<FTerrainChunkMesh> ChunkMeshes;
+    TArray<FVector2D> RiverPath;
+    TArray<FTransform> WaterTransforms;
+};
+
 UCLASS()
 class TESTES_API APerlinMapProceduralMeshGenerator : public AActor
 {
@@ -36,6 +69,57 @@ public:
     UPROPERTY(EditAnywhere, Category = "Map Settings")
     float HeightMultiplier = 300.0f;
 
+    // Quads por lado de cada chunk (cada chunk é uma seção da mesh)
+    UPROPERTY(EditAnywhere, Category = "Map Settings", meta = (ClampMin = "1"))
+    int32 ChunkSize = 64;
+
+    // Gera o terreno fora da game thread (só o commit da mesh roda nela)
+    UPROPERTY(EditAnywhere, Category = "Map Settings")
+    bool bGenerateAsync = true;
+
+    // Guarda o terreno gerado em Saved/TerrainCache e o reaproveita enquanto
+    // as configurações de mapa e ruído forem as mesmas
+    UPROPERTY(EditAnywhere, Category = "Map Settings")
+    bool bUseGenerationCache = true;
+
+    // Espaço máximo do cache em disco; os terrenos usados há mais tempo
+    // são apagados quando uma gravação passa do limite
+    UPROPERTY(EditAnywhere, Category = "Map Settings", meta = (EditCondition = "bUseGenerationCache", ClampMin = "1", Units = "MB"))
+    int32 GenerationCacheMaxMB = 1024;
+
+    // Guarda as alturas em 16 bits com mínimo/escala por chunk (metade da
+    // memória de float). Edições e a mesh decodificam só o trecho que usam.
+    UPROPERTY(EditAnywhere, Category = "Map Settings")
+    bool bQuantizeHeights = false;
+
+    // Comprime (delta + Oodle) os chunks quantizados longe de todos os
+    // jogadores e sem acesso recente; voltam ao serem lidos ou editados.
+    // Só vale com bQuantizeHeights.
+    UPROPERTY(EditAnywhere, Category = "Residency", meta = (EditCondition = "bQuantizeHeights"))
+    bool bCompressColdChunks = false;
+
+    // Memória máxima das alturas; acima dela comprime também chunks mais
+    // próximos (ociosos). 0 = sem limite. Passes no mapa inteiro (erosão,
+    // exportação) não descomprimem a camada fria, mas trabalham numa cópia
+    // float temporária do mapa que não entra nesta conta.
+    UPROPERTY(EditAnywhere, Category = "Residency", meta = (ClampMin = "0", Units = "MB"))
+    float ResidencyBudgetMB = 0.0f;
+
+    // Distância (espaço local) a partir da qual um chunk ocioso é comprimido
+    UPROPERTY(EditAnywhere, Category = "Residency", meta = (ClampMin = "0"))
+    float ColdChunkDistance = 20000.0f;
+
+    UPROPERTY(EditAnywhere, Category = "Residency", meta = (ClampMin = "0.1", Units = "s"))
+    float ResidencyUpdateInterval = 2.0f;
+
+    // Tempo de CPU por frame dado à erosão incremental (StartErosionJob)
+    UPROPERTY(EditAnywhere, Category = "Erosion", meta = (ClampMin = "0.1", Units = "ms"))
+    float ErosionBudgetMs = 4.0f;
+
+    // Intervalo entre atualizações da mesh enquanto a erosão incremental roda
+    UPROPERTY(EditAnywhere, Category = "Erosion", meta = (ClampMin = "0", Units = "s"))
+    float ErosionRefreshInterval = 0.25f;
+
     UPROPERTY(EditAnywhere, Category = "Noise Settings")
     int32 Octaves = 4;
 
@@ -78,10 +162,28 @@ public:
     UProceduralMeshComponent* ProceduralMesh;
 
     UPROPERTY()
-    TArray<FVector> TerrainVertices;
+    FTerrainHeightfield TerrainHeightfield;
 
-    UPROPERTY()
-    TArray<int32> TerrainTriangles;
+    FTerrainChunkGrid TerrainChunks;
+
+    // Disparado na game thread quando o terreno gerado é aplicado à mesh
+    UPROPERTY(BlueprintAssignable, Category = "Terrain")
+    FOnTerrainGenerated OnTerrainGenerated;
+
+    UFUNCTION(BlueprintPure, Category = "Terrain")
+    bool IsTerrainReady() const;
+
+    // Erro e memória da quantização atual, edições incluídas (zerado sem
+    // bQuantizeHeights)
+    UFUNCTION(BlueprintPure, Category = "Terrain")
+    FTerrainQuantizationReport GetHeightPrecisionReport() const;
+
+    // Revisa a camada fria agora (normalmente roda a cada ResidencyUpdateInterval)
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Residency")
+    void UpdateChunkResidency();
+
+    UFUNCTION(BlueprintPure, Category = "Terrain|Residency")
+    FTerrainResidencyStats GetResidencyStats() const;
 
     UFUNCTION(BlueprintCallable, Category = "Terrain")
     void ModifyTerrainAt(FVector WorldLocation, float Radius, float DeltaHeight);
@@ -92,9 +194,100 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Terrain")
     void AddTributaryAt(FVector StartLocation);
 
+    // Consultas de rio em coordenadas de mundo (baratas o bastante para rodar todo frame)
+    UFUNCTION(BlueprintPure, Category = "Terrain|Rivers")
+    float GetDistanceToRiver(FVector WorldLocation) const;
+
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Rivers")
+    bool FindNearestRiverPoint(FVector WorldLocation, FVector& OutRiverPoint, float& OutDistance) const;
+
+    UFUNCTION(BlueprintPure, Category = "Terrain|Rivers")
+    bool IsNearRiver(FVector WorldLocation, float Radius) const;
+
     UFUNCTION(BlueprintCallable, Category = "Terrain")
     void SimulateErosion(int32 NumIterations, float RainAmount, float ErosionStrength);
 
+    // Erosão em duas resoluções: CoarseIterations num mapa reduzido
+    // DownsampleFactor vezes e FineIterations na resolução cheia
+    UFUNCTION(BlueprintCallable, Category = "Terrain")
+    void SimulateErosionMultiResolution(int32 CoarseIterations, int32 FineIterations, int32 DownsampleFactor, float RainAmount, float ErosionStrength);
+
+    // Erosão térmica: suaviza encostas acima de TalusAngle (graus). Barata o
+    // bastante para rodar depois de cada lote de edições no terreno.
+    UFUNCTION(BlueprintCallable, Category = "Terrain")
+    void SimulateThermalErosion(int32 NumIterations, float TalusAngle = 35.0f);
+
+    // Bake offline de mundos maiores que a memória: gera o ruído do ator no
+    // arquivo Path (como ExportNoiseToHeightfieldFile) e roda a erosão
+    // hidráulica tile a tile, NumPasses passadas de IterationsPerPass
+    // iterações. Cada tile é lido com um halo de 3 * IterationsPerPass + 1
+    // vértices, então passadas curtas saem mais baratas, mas água e
+    // sedimento recomeçam do zero a cada passada: o resultado não é o de
+    // SimulateErosion com NumPasses * IterationsPerPass iterações (ver
+    // FTerrainTiledErosion). Abre com ImportHeightfieldFile; o terreno do
+    // ator não muda.
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Bake")
+    bool BakeTiledErosion(const FString& Path, int32 WorldSizeX, int32 WorldSizeY, int32 TileSize, int32 NumPasses, int32 IterationsPerPass, float RainAmount, float ErosionStrength);
+
+    // Erosão por gotas: cava ravinas mais marcadas que a erosão por grade
+    UFUNCTION(BlueprintCallable, Category = "Terrain")
+    void SimulateDropletErosion(int32 NumDroplets, float ErosionStrength);
+
+    // Erosão incremental: roda ErosionBudgetMs por frame e atualiza a mesh a
+    // cada ErosionRefreshInterval. Edições feitas no terreno enquanto ela roda
+    // são sobrescritas na próxima atualização.
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Erosion")
+    void StartErosionJob(int32 NumIterations, float RainAmount, float ErosionStrength);
+
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Erosion")
+    void PauseErosionJob();
+
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Erosion")
+    void ResumeErosionJob();
+
+    // Para a erosão; o terreno fica como na última atualização da mesh
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Erosion")
+    void CancelErosionJob();
+
+    UFUNCTION(BlueprintPure, Category = "Terrain|Erosion")
+    bool IsErosionJobRunning() const;
+
+    // Fração das iterações já simuladas (0 sem erosão em andamento)
+    UFUNCTION(BlueprintPure, Category = "Terrain|Erosion")
+    float GetErosionProgress() const;
+
+    // Acertos/faltas do cache de ruído, compartilhado por todos os geradores
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Cache")
+    static void GetNoiseCacheStats(int64& OutHits, int64& OutMisses, int32& OutNumTiles);
+
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Cache")
+    static void ClearNoiseCache();
+
+    // Memória máxima do cache de ruído (padrão 256 MB). Mapas maiores que o
+    // orçamento regeneram o ruído a cada geração.
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Cache")
+    static void SetNoiseCacheBudget(int32 MegaBytes);
+
+    // Apaga os terrenos guardados em disco (ver bUseGenerationCache)
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Cache")
+    static void ClearGenerationCache();
+
+    // Arquivo de heightfield em tiles quantizados (ver FTerrainHeightfieldFile).
+    // Caminhos relativos são resolvidos a partir de Saved/.
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Bake")
+    bool ExportHeightfieldFile(const FString& Path, int32 TileSize = 256);
+
+    // Gera direto no arquivo um mundo de WorldSizeX x WorldSizeY quads com o
+    // ruído do ator, um tile por vez (não precisa caber na memória)
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Bake")
+    bool ExportNoiseToHeightfieldFile(const FString& Path, int32 WorldSizeX, int32 WorldSizeY, int32 TileSize = 256);
+
+    // Substitui o terreno do ator pelo do arquivo (o rio atual é descartado).
+    // Com bQuantizeHeights o mapa não passa inteiro pela memória em float:
+    // cada chunk lê do arquivo só a própria região.
+    UFUNCTION(BlueprintCallable, Category = "Terrain|Bake")
+    bool ImportHeightfieldFile(const FString& Path);
+
     UFUNCTION(BlueprintCallable)
     void SimulateErosionAt(FVector WorldLocation, float Radius, int32 NumIterations, float RainAmount, float ErosionStrength);
 
@@ -106,17 +299,70 @@ public:
     UInstancedStaticMeshComponent* WaterISM;
 
     TArray<FVector2D> MainRiverPath;
-    TArray<TArray<FVector2D>> AllRiverPaths;
+
+    // Rio principal e afluentes, indexados para consultas de proximidade
+    FTerrainRiverNetwork RiverNetwork;
 
 
 private:
     UInstancedStaticMeshComponent* InstancedMeshComp;
 
+    bool bTerrainReady = false;
+    bool bGenerationInProgress = false;
+
+    FTerrainErosionJob ErosionJob;
+    bool bErosionJobPaused = false;
+    float TimeSinceErosionRefresh = 0.0f;
+
+    FTerrainLocalErosion LocalErosion;
+
+    // Mantida entre chamadas para as gotas continuarem a sequência; volta a
+    // zero com um terreno novo ou outros parâmetros
+    FTerrainDropletErosion DropletErosion;
+
+    // Com bQuantizeHeights, as alturas ficam aqui e TerrainHeightfield só
+    // guarda as dimensões
+    FTerrainQuantizedHeightfield QuantizedHeights;
+
+    FTimerHandle ResidencyTimer;
+    FTerrainResidencySettings GetResidencySettings() const;
+
+    bool HasTerrainHeights() const;
+    float GetTerrainHeight(int32 X, int32 Y) const;
+    FTerrainDirtyRegion GetTerrainRegionInBox(const FVector2D& BoxMin, const FVector2D& BoxMax) const;
+    FTerrainDirtyRegion GetTerrainRegionInRadius(const FVector2D& Center, float Radius) const;
+
+    // Roda Edit sobre as alturas de Region e devolve a região alterada na
+    // grade. Sem quantização Edit recebe o próprio TerrainHeightfield; com
+    // ela, uma janela decodificada cujo canto fica em Offset (espaço local).
+    // Passes no mapa inteiro usam Streaming para não esvaziar a camada fria.
+    FTerrainDirtyRegion EditHeights(const FTerrainDirtyRegion& Region, TFunctionRef<FTerrainDirtyRegion(FTerrainHeightfield& Heights, const FVector2D& Offset)> Edit, ETerrainChunkAccess Access = ETerrainChunkAccess::Resident);
+
+    void RefreshErosionJob();
+
     void GenerateMap();
-    float GeneratePerlinNoise(float X, float Y, FRandomStream& RandStream);
+    FTerrainNoiseSettings GetNoiseSettings() const;
+    static void BuildTerrain(const FTerrainGenerationParams& Params, FTerrainGenerationResult& Result);
+    static uint64 ComputeGenerationKey(const FTerrainGenerationParams& Params);
+    static void GenerateHeightfield(const FTerrainGenerationParams& Params, FTerrainGenerationResult& Result);
+
+    // Com HeightsFile (importação quantizada), Result.Heightfield só traz as
+    // dimensões e as alturas são codificadas lendo o arquivo chunk a chunk
+    void CommitTerrain(FTerrainGenerationResult& Result, const FTerrainHeightfieldFile* HeightsFile = nullptr);
+
+    void MarkTerrainDirty(const FTerrainDirtyRegion& Region);
+    void FlushDirtyChunks();
     void CarveRiver(const FVector2D& Start, const FVector2D& End, float Width, float Depth);
-    TArray<FVector2D> GenerateCurvedRiverPath(int32 NumPoints, FVector2D Start, FVector2D End, float Amplitude, float Frequency);
+    static TArray<FVector2D> GenerateCurvedRiverPath(int32 NumPoints, FVector2D Start, FVector2D End, float Amplitude, float Frequency);
     void CarveCurvedRiver(const TArray<FVector2D>& RiverPath, float Width, float Depth);
+    static FTerrainDirtyRegion CarveRiverPath(FTerrainHeightfield& Heightfield, const TArray<FVector2D>& RiverPath, float Width, float Depth, TArray<FTransform>& OutWaterTransforms);
+
+    // Caixa do segmento Segment -> Segment + 1 expandida por Width (espaço local)
+    static FBox2D GetRiverSegmentBox(const TArray<FVector2D>& RiverPath, int32 Segment, float Width);
+
+    // União dos corredores dos segmentos na grade do terreno: tudo o que
+    // CarveRiverPath pode alterar
+    FTerrainDirtyRegion GetRiverCorridor(const TArray<FVector2D>& RiverPath, float Width) const;
 
 
 
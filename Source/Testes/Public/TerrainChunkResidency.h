@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TerrainChunkResidency.generated.h"
+
+class FTerrainQuantizedHeightfield;
+
+// Estado da camada fria depois da última atualização
+USTRUCT(BlueprintType)
+struct TESTES_API FTerrainResidencyStats
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Terrain")
+    int32 ResidentChunks = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Terrain")
+    int32 CompressedChunks = 0;
+
+    // Memória das alturas (chunks residentes + comprimidos)
+    UPROPERTY(BlueprintReadOnly, Category = "Terrain")
+    int64 UsedBytes = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Terrain")
+    int64 BudgetBytes = 0;
+
+    // Totais desde a geração do terreno
+    UPROPERTY(BlueprintReadOnly, Category = "Terrain")
+    int64 Compressions = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Terrain")
+    int64 Decompressions = 0;
+};
+
+struct TESTES_API FTerrainResidencySettings
+{
+    // Memória máxima das alturas; 0 = sem limite (só a distância vale)
+    int64 BudgetBytes = 0;
+
+    // Chunks a mais que isto de todos os observadores (espaço local) são
+    // comprimidos assim que ficam ociosos
+    float ColdDistance = 20000.0f;
+
+    // Atualizações sem nenhum acesso para um chunk contar como ocioso
+    int32 IdleUpdates = 2;
+};
+
+// Decide quais chunks de um FTerrainQuantizedHeightfield ficam
+// comprimidos. Nunca descomprime: isso acontece sozinho no próximo acesso.
+class TESTES_API FTerrainChunkResidency
+{
+public:
+    // Comprime os chunks ociosos além de ColdDistance e, se a memória
+    // ainda passar do orçamento, os ociosos mais distantes até caber.
+    // Chame da thread que edita o terreno, sem leituras em andamento.
+    static FTerrainResidencyStats Update(FTerrainQuantizedHeightfield& Heights, TArrayView<const FVector2D> Viewers, const FTerrainResidencySettings& Settings);
+
+    static FTerrainResidencyStats GetStats(const FTerrainQuantizedHeightfield& Heights, const FTerrainResidencySettings& Settings);
+};
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshComponent.h"
+#include "TerrainHeightfield.h"
+
+// Divide o heightfield em chunks quadrados de ChunkSize quads. Cada chunk
+// vira uma seção da mesh (índice = ChunkY * NumChunksX + ChunkX) e guarda
+// um bit de "sujo" para que só os chunks editados sejam reenviados.
+struct TESTES_API FTerrainChunkGrid
+{
+    int32 ChunkSize = 64;
+    int32 NumChunksX = 0;
+    int32 NumChunksY = 0;
+
+    void Init(const FTerrainHeightfield& Heightfield, int32 InChunkSize);
+
+    int32 Num() const { return NumChunksX * NumChunksY; }
+    int32 GetChunkIndex(int32 ChunkX, int32 ChunkY) const { return ChunkY * NumChunksX + ChunkX; }
+
+    // Vértices [Min, Max) do chunk, incluindo a borda compartilhada com o vizinho
+    FTerrainDirtyRegion GetVertexRegion(int32 ChunkIndex) const;
+
+    // Marca todos os chunks que contêm algum vértice da região
+    void MarkDirty(const FTerrainDirtyRegion& Region);
+    void MarkAllDirty();
+
+    // Devolve os chunks sujos e limpa as marcas
+    void ConsumeDirtyChunks(TArray<int32>& OutChunks);
+
+private:
+    // Último vértice em cada eixo (NumX - 1, NumY - 1)
+    int32 LastVertexX = 0;
+    int32 LastVertexY = 0;
+
+    TBitArray<> DirtyChunks;
+};
+
+// Geometria de um chunk pronta para Create/UpdateMeshSection
+struct TESTES_API FTerrainChunkMesh
+{
+    TArray<FVector> Vertices;
+    TArray<int32> Triangles;
+    TArray<FVector> Normals;
+    TArray<FVector2D> UVs;
+    TArray<FProcMeshTangent> Tangents;
+
+    // Seção completa (BuildVertices + topologia e UVs) para CreateMeshSection
+    void BuildSection(const FTerrainHeightfield& Heightfield, const FTerrainDirtyRegion& VertexRegion);
+
+    // Posições, normais e tangentes, para UpdateMeshSection. As normais leem
+    // os vizinhos fora do chunk, então editar um vértice suja também os chunks
+    // que tocam a borda de 1 vértice ao redor dele. A geração, a importação e
+    // as edições usam todas este mesmo cálculo, então não há emendas de luz
+    // entre chunks reconstruídos e os originais.
+    void BuildVertices(const FTerrainHeightfield& Heightfield, const FTerrainDirtyRegion& VertexRegion);
+
+    // O mesmo a partir de uma janela da grade (decodificada ou lida de um
+    // arquivo) cujo canto fica em Origin. VertexRegion vem em coordenadas da
+    // grade e a janela precisa cobri-la com a borda de 1 vértice (recortada
+    // à grade) lida pelas normais; GridSize é o número de vértices da grade.
+    void BuildSection(const FTerrainHeightfield& Window, const FIntPoint& Origin, const FIntPoint& GridSize, const FTerrainDirtyRegion& VertexRegion);
+    void BuildVertices(const FTerrainHeightfield& Window, const FIntPoint& Origin, const FTerrainDirtyRegion& VertexRegion);
+
+private:
+    // UVs e triângulos: só dependem da região e do tamanho da grade
+    void BuildTopology(const FTerrainDirtyRegion& VertexRegion, const FIntPoint& GridSize);
+};
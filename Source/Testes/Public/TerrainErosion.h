@@ -0,0 +1,276 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TerrainHeightfield.h"
+
+
+// Parâmetros da erosão hidráulica. A simulação roda em unidades de célula
+// (alturas divididas por CellSize), então os coeficientes não dependem da
+// escala do mapa; só RainAmount está em unidades do mundo.
+struct TESTES_API FTerrainHydraulicSettings
+{
+    // Lâmina de água adicionada a cada iteração (unidades do mundo)
+    float RainAmount = 1.0f;
+
+    float TimeStep = 0.02f;
+    float PipeArea = 20.0f;
+    float Gravity = 9.81f;
+
+    // Quanto sedimento a água carrega por unidade de velocidade e inclinação
+    float SedimentCapacity = 1.0f;
+
+    // Fração da diferença para a capacidade dissolvida/depositada por iteração
+    float ErosionRate = 0.5f;
+    float DepositionRate = 1.0f;
+
+    // Fração da água evaporada por unidade de tempo
+    float EvaporationRate = 0.5f;
+
+    // Inclinação mínima usada na capacidade (evita capacidade zero no plano)
+    float MinTilt = 0.05f;
+};
+
+// Erosão hidráulica por "virtual pipes" (fluxo entre vizinhos 4-conectados,
+// transporte semi-lagrangiano do sedimento). Cada passo é uma sequência de
+// passadas paralelas por linha; toda passada que lê vizinhos de um campo que
+// ela mesma escreve usa buffer duplo, então o resultado não depende da ordem
+// nem do número de threads.
+class TESTES_API FTerrainHydraulicErosion
+{
+public:
+    // Copia as alturas do heightfield e zera água, sedimento e fluxo
+    void Init(const FTerrainHeightfield& Heightfield, const FTerrainHydraulicSettings& InSettings);
+
+    void Step(int32 NumIterations);
+
+    // Escreve as alturas simuladas no heightfield (mesmas dimensões da
+    // simulação) e devolve a região em que alguma altura mudou
+    FTerrainDirtyRegion WriteBack(FTerrainHeightfield& Heightfield) const;
+
+    // Mesmo que acima para uma janela da grade com canto em Origin; a região
+    // devolvida é relativa à janela
+    FTerrainDirtyRegion WriteBack(FTerrainHeightfield& Window, const FIntPoint& Origin) const;
+
+    // Libera os buffers da simulação
+    void Reset();
+
+    bool IsEmpty() const { return Terrain.Num() == 0; }
+    int32 GetIterationsDone() const { return IterationsDone; }
+
+    // Até onde (em vértices) uma alteração se propaga em NumIterations: a
+    // cada iteração o fluxo lê a água dos vizinhos, a água lê o fluxo dos
+    // vizinhos e o transporte lê o sedimento dos vizinhos (o recuo
+    // semi-lagrangiano é limitado a 1 célula)
+    static constexpr int32 ReachPerIteration = 3;
+    static int32 GetReach(int32 NumIterations) { return ReachPerIteration * FMath::Max(NumIterations, 0); }
+
+private:
+    void UpdateFlux();
+    void UpdateWater();
+    void ErodeAndDeposit();
+    void TransportSediment();
+
+    FORCEINLINE bool HasNeighbor(int32 X, int32 Y, int32 Pipe) const
+    {
+        switch (Pipe)
+        {
+        case 0: return X > 0;
+        case 1: return X < NumX - 1;
+        case 2: return Y > 0;
+        default: return Y < NumY - 1;
+        }
+    }
+
+    FTerrainHydraulicSettings Settings;
+
+    int32 NumX = 0;
+    int32 NumY = 0;
+    float CellSize = 1.0f;
+    float Rain = 0.0f;
+    int32 IterationsDone = 0;
+
+    // Deslocamento de índice de cada cano (-X, +X, -Y, +Y)
+    int32 NeighborOffsets[4] = { 0, 0, 0, 0 };
+
+    TArray<float> Terrain;
+    TArray<float> TerrainNext;
+    TArray<float> Water;
+    TArray<float> Sediment;
+    TArray<float> SedimentNext;
+    TArray<float> VelocityX;
+    TArray<float> VelocityY;
+
+    // 4 fluxos de saída por célula, na ordem de NeighborOffsets
+    TArray<float> Flux;
+};
+
+// Erosão hidráulica incremental: avança em fatias de tempo para não travar
+// o frame. As alturas simuladas ficam no solver até WriteBack.
+class TESTES_API FTerrainErosionJob
+{
+public:
+    void Start(const FTerrainHeightfield& Heightfield, const FTerrainHydraulicSettings& Settings, int32 InTotalIterations);
+
+    // Roda iterações até gastar BudgetSeconds (sempre ao menos uma).
+    // Devolve true quando todas as iterações foram feitas.
+    bool Advance(double BudgetSeconds);
+
+    // Descarta o progresso ainda não escrito no heightfield
+    void Cancel();
+
+    bool IsActive() const { return !Solver.IsEmpty(); }
+    bool IsFinished() const { return IsActive() && Solver.GetIterationsDone() >= TotalIterations; }
+    float GetProgress() const;
+
+    FTerrainDirtyRegion WriteBack(FTerrainHeightfield& Heightfield) const { return Solver.WriteBack(Heightfield); }
+    FTerrainDirtyRegion WriteBack(FTerrainHeightfield& Window, const FIntPoint& Origin) const { return Solver.WriteBack(Window, Origin); }
+
+private:
+    FTerrainHydraulicErosion Solver;
+    int32 TotalIterations = 0;
+};
+
+// Erosão hidráulica em duas resoluções: a maior parte das iterações roda num
+// heightfield reduzido Factor vezes (a água atravessa o mapa com bem menos
+// passos), a diferença é interpolada de volta para a resolução cheia e umas
+// poucas iterações finais recuperam o detalhe.
+struct TESTES_API FTerrainMultiResolutionErosion
+{
+    static FTerrainDirtyRegion Run(FTerrainHeightfield& Heightfield, const FTerrainHydraulicSettings& Settings, int32 Factor, int32 CoarseIterations, int32 FineIterations);
+};
+
+// Erosão térmica: o material escorrega de encostas mais íngremes que o
+// ângulo de repouso para os vizinhos mais baixos (8-conectados).
+struct TESTES_API FTerrainThermalSettings
+{
+    // Ângulo de repouso em graus
+    float TalusAngle = 35.0f;
+
+    // Fração do excesso acima do ângulo movida por iteração (0..1)
+    float Rate = 0.5f;
+};
+
+// Cada iteração é um stencil paralelo por linha com buffer duplo. A troca
+// entre dois vizinhos é antissimétrica, então a massa se conserva e o
+// resultado não depende da ordem nem do número de threads.
+struct TESTES_API FTerrainThermalErosion
+{
+    // Devolve a região em que alguma altura mudou
+    static FTerrainDirtyRegion Run(FTerrainHeightfield& Heightfield, const FTerrainThermalSettings& Settings, int32 NumIterations);
+};
+
+// Parâmetros da erosão por gotas. Como na erosão hidráulica, alturas e
+// sedimento são medidos em unidades de célula.
+struct TESTES_API FTerrainDropletSettings
+{
+    int32 Seed = 1337;
+
+    // Passos máximos de cada gota (cada passo anda uma célula)
+    int32 MaxLifetime = 30;
+
+    // 0 = segue o gradiente, 1 = mantém a direção anterior
+    float Inertia = 0.05f;
+
+    float SedimentCapacity = 4.0f;
+    float MinCapacity = 0.01f;
+    float ErodeSpeed = 0.3f;
+    float DepositSpeed = 0.3f;
+    float EvaporateSpeed = 0.01f;
+    float Gravity = 4.0f;
+    float InitialWater = 1.0f;
+    float InitialSpeed = 1.0f;
+
+    // Gotas por lote e lotes simulados em paralelo a cada rodada. São fixos
+    // (não dependem do número de threads), então o resultado é determinístico.
+    int32 DropletsPerBatch = 256;
+    int32 BatchesPerRound = 64;
+};
+
+// Erosão por gotas: cada gota desce o heightfield arrancando e depositando
+// sedimento. Os lotes de uma rodada leem o mesmo retrato das alturas e
+// acumulam suas alterações em listas próprias, aplicadas em ordem de lote
+// no fim da rodada.
+class TESTES_API FTerrainDropletErosion
+{
+public:
+    void Init(const FTerrainDropletSettings& InSettings);
+
+    // Simula NumDroplets gotas (continuando a sequência aleatória das
+    // chamadas anteriores) e devolve a região alterada
+    FTerrainDirtyRegion Step(FTerrainHeightfield& Heightfield, int32 NumDroplets);
+
+    // Descarta a sequência; o próximo uso precisa de Init
+    void Reset();
+
+    bool IsInitialized() const { return Batches.Num() > 0; }
+    const FTerrainDropletSettings& GetSettings() const { return Settings; }
+    int32 GetDropletsDone() const { return DropletsDone; }
+
+private:
+    struct FHeightDelta
+    {
+        int32 Index;
+        float Delta;
+    };
+
+    struct FBatch
+    {
+        TArray<FHeightDelta> Deltas;
+        FTerrainDirtyRegion Dirty;
+    };
+
+    void SimulateDroplet(const FTerrainHeightfield& Heightfield, int32 DropletIndex, FBatch& Batch) const;
+
+    FTerrainDropletSettings Settings;
+    int32 DropletsDone = 0;
+    TArray<FBatch> Batches;
+};
+
+// Erosão localizada usada como ferramenta de gameplay: a água escorre para o
+// vizinho mais baixo e desgasta o solo só dentro do raio. Roda numa janela
+// (raio + 1 vértice de halo, onde a água que sai do raio se acumula)
+// copiada para buffers compactos, então o custo é proporcional à janela e
+// não ao mapa. Os buffers são reaproveitados entre chamadas.
+class TESTES_API FTerrainLocalErosion
+{
+public:
+    FTerrainDirtyRegion Run(FTerrainHeightfield& Heightfield, const FVector2D& Center, float Radius, int32 NumIterations, float RainAmount, float ErosionStrength);
+
+private:
+    TArray<float> Ground;
+    TArray<float> Water;
+    TArray<float> Erosion;
+
+    // Índices (na janela) dos vértices dentro do raio, em ordem de linha
+    TArray<int32> Affected;
+};
+
+// Erosão fora da memória para mapas gravados em FTerrainHeightfieldFile.
+// Cada passada processa um tile por vez: lê do arquivo mapeado o tile com
+// Halo vértices dos vizinhos, roda Kernel nessa janela e grava só o miolo
+// (o tile) num arquivo novo, que substitui o original no fim da passada.
+// Como todos os tiles de uma passada leem o estado da passada anterior, as
+// bordas são trocadas entre vizinhos a cada passada; com o halo abaixo, o
+// miolo de cada tile sai igual ao da mesma passada rodada no mapa inteiro.
+//
+// Só as alturas atravessam as passadas: o kernel começa cada janela do
+// zero, então água, sedimento e fluxo do modelo de canos zeram a cada
+// passada (o sedimento ainda em suspensão no fim dela se perde). Por isso
+// NumPasses x N iterações não dá o mesmo terreno que SimulateErosion com o
+// mesmo total: os rios não se acumulam de uma passada para outra, e
+// passadas curtas erodem menos.
+//
+// O pico de memória é uma janela (tile + halo); cada passada regrava as
+// alturas em uint16, então o passo de quantização do tile entra uma vez
+// por passada.
+struct TESTES_API FTerrainTiledErosion
+{
+    // Kernel recebe a janela como um heightfield comum (ex.: erosão
+    // hidráulica ou térmica). A borda da janela age como parede, então o
+    // halo deve passar do alcance do kernel numa passada (para o modelo de
+    // canos, FTerrainHydraulicErosion::GetReach(Iterações) + 1). O resultado
+    // fica no próprio Path.
+    static bool Run(const FString& Path, int32 Halo, int32 NumPasses, TFunctionRef<void(FTerrainHeightfield&)> Kernel);
+};
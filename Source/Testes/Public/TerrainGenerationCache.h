@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Hash/xxhash.h"
+#include "TerrainHeightfield.h"
+
+// Chave do cache de geração: hash de todas as entradas que mudam o
+// resultado. Cada campo entra com seus bytes, na ordem em que é somado.
+struct TESTES_API FTerrainGenerationKey
+{
+    FTerrainGenerationKey();
+
+    template <typename T>
+    FTerrainGenerationKey& Add(const T& Value)
+    {
+        static_assert(TIsPODType<T>::Value, "Só tipos POD entram na chave");
+        Builder.Update(&Value, sizeof(T));
+        return *this;
+    }
+
+    uint64 Get() const { return Builder.Finalize().Hash; }
+
+private:
+    FXxHash64Builder Builder;
+};
+
+// Cache em disco (Saved/TerrainCache) do resultado da geração: alturas
+// finais, caminho do rio e instâncias de água. Um arquivo por
+// chave, lido de uma vez só quando a chave bate; Trim limita o espaço
+// total em disco.
+class TESTES_API FTerrainGenerationCache
+{
+public:
+    // Aumente quando a geração mudar sem mudar as entradas da chave
+    static constexpr uint32 Version = 2;
+
+    static FString GetDirectory();
+    static FString GetPath(uint64 Key);
+
+    static bool Load(uint64 Key, FTerrainHeightfield& OutHeightfield, TArray<FVector2D>& OutRiverPath, TArray<FTransform>& OutWaterTransforms);
+    static bool Save(uint64 Key, const FTerrainHeightfield& Heightfield, const TArray<FVector2D>& RiverPath, const TArray<FTransform>& WaterTransforms);
+
+    // Apaga os arquivos usados há mais tempo (Load renova a data) até o
+    // total caber em MaxBytes, sem nunca apagar KeepKey. Devolve quantos
+    // arquivos foram apagados.
+    static int32 Trim(int64 MaxBytes, uint64 KeepKey);
+
+    // Apaga todos os arquivos do cache
+    static bool Clear();
+};
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TerrainHeightfield.generated.h"
+
+// Retângulo de vértices [Min, Max) alterado por uma operação no terreno
+struct TESTES_API FTerrainDirtyRegion
+{
+    FIntPoint Min = FIntPoint(MAX_int32, MAX_int32);
+    FIntPoint Max = FIntPoint(MIN_int32, MIN_int32);
+
+    bool IsEmpty() const { return Min.X >= Max.X || Min.Y >= Max.Y; }
+
+    void Include(int32 X, int32 Y)
+    {
+        Min.X = FMath::Min(Min.X, X);
+        Min.Y = FMath::Min(Min.Y, Y);
+        Max.X = FMath::Max(Max.X, X + 1);
+        Max.Y = FMath::Max(Max.Y, Y + 1);
+    }
+
+    void Include(const FTerrainDirtyRegion& Other)
+    {
+        if (Other.IsEmpty()) return;
+        Min.X = FMath::Min(Min.X, Other.Min.X);
+        Min.Y = FMath::Min(Min.Y, Other.Min.Y);
+        Max.X = FMath::Max(Max.X, Other.Max.X);
+        Max.Y = FMath::Max(Max.Y, Other.Max.Y);
+    }
+
+    // Cresce a região Amount vértices para cada lado (ex.: borda das normais)
+    FTerrainDirtyRegion ExpandBy(int32 Amount) const
+    {
+        FTerrainDirtyRegion Region = *this;
+        if (!IsEmpty())
+        {
+            Region.Min -= FIntPoint(Amount, Amount);
+            Region.Max += FIntPoint(Amount, Amount);
+        }
+        return Region;
+    }
+};
+
+// Grade regular de alturas do terreno. X/Y de cada vértice vêm do índice
+// (X * CellSize, Y * CellSize), então só a altura é armazenada.
+USTRUCT()
+struct TESTES_API FTerrainHeightfield
+{
+    GENERATED_BODY()
+
+    // Vértices por eixo (MapWidth + 1, MapHeight + 1)
+    UPROPERTY()
+    int32 NumX = 0;
+
+    UPROPERTY()
+    int32 NumY = 0;
+
+    // Distância entre vértices vizinhos no espaço local
+    UPROPERTY()
+    float CellSize = 100.0f;
+
+    // Alturas em ordem de linha (Y * NumX + X)
+    UPROPERTY()
+    TArray<float> Heights;
+
+    void Init(int32 InNumX, int32 InNumY, float InCellSize);
+
+    bool IsEmpty() const { return Heights.Num() == 0; }
+    int32 Num() const { return Heights.Num(); }
+
+    FORCEINLINE int32 GetIndex(int32 X, int32 Y) const { return Y * NumX + X; }
+    FORCEINLINE bool IsValid(int32 X, int32 Y) const { return X >= 0 && X < NumX && Y >= 0 && Y < NumY; }
+
+    FORCEINLINE float GetHeight(int32 X, int32 Y) const { return Heights[GetIndex(X, Y)]; }
+    FORCEINLINE float& GetHeight(int32 X, int32 Y) { return Heights[GetIndex(X, Y)]; }
+
+    // Posição local (X/Y) do vértice da grade
+    FORCEINLINE FVector2D GetLocation2D(int32 X, int32 Y) const { return FVector2D(X * CellSize, Y * CellSize); }
+    FORCEINLINE FVector GetVertex(int32 X, int32 Y) const { return FVector(X * CellSize, Y * CellSize, GetHeight(X, Y)); }
+
+    // Declive (dAltura/dX, dAltura/dY) por diferença central (unilateral nas bordas da grade)
+    FORCEINLINE FVector2f ComputeSlope(int32 X, int32 Y) const
+    {
+        const int32 X0 = FMath::Max(X - 1, 0);
+        const int32 X1 = FMath::Min(X + 1, NumX - 1);
+        const int32 Y0 = FMath::Max(Y - 1, 0);
+        const int32 Y1 = FMath::Min(Y + 1, NumY - 1);
+
+        return FVector2f(
+            (GetHeight(X1, Y) - GetHeight(X0, Y)) / (FMath::Max(X1 - X0, 1) * CellSize),
+            (GetHeight(X, Y1) - GetHeight(X, Y0)) / (FMath::Max(Y1 - Y0, 1) * CellSize)
+        );
+    }
+
+    // Normal e tangente a partir do declive (calculado ou analítico)
+    static FORCEINLINE void SlopeToNormalAndTangent(const FVector2f& Slope, FVector& OutNormal, FVector& OutTangent)
+    {
+        OutNormal = FVector(-Slope.X, -Slope.Y, 1.0f).GetUnsafeNormal();
+        OutTangent = FVector(1.0f, 0.0f, Slope.X).GetUnsafeNormal();
+    }
+
+    FORCEINLINE void ComputeNormalAndTangent(int32 X, int32 Y, FVector& OutNormal, FVector& OutTangent) const
+    {
+        SlopeToNormalAndTangent(ComputeSlope(X, Y), OutNormal, OutTangent);
+    }
+
+    FTerrainDirtyRegion GetFullRegion() const
+    {
+        FTerrainDirtyRegion Region;
+        Region.Min = FIntPoint(0, 0);
+        Region.Max = FIntPoint(NumX, NumY);
+        return Region;
+    }
+
+    // Retângulo de vértices dentro da caixa [BoxMin, BoxMax] (espaço local),
+    // já limitado à grade
+    FTerrainDirtyRegion GetRegionInBox(const FVector2D& BoxMin, const FVector2D& BoxMax) const;
+
+    // Retângulo de vértices que pode estar a até Radius de Center (espaço local)
+    FTerrainDirtyRegion GetRegionInRadius(const FVector2D& Center, float Radius) const;
+
+    // Pincéis circulares com falloff linear. Só visitam os vértices do retângulo
+    // que envolve o raio e devolvem a região efetivamente alterada.
+    FTerrainDirtyRegion RaiseInRadius(const FVector2D& Center, float Radius, float DeltaHeight);
+    FTerrainDirtyRegion LevelInRadius(const FVector2D& Center, float Radius, float TargetHeight);
+};
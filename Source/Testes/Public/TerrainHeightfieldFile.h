@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TerrainHeightfield.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// Arquivo de heightfield em tiles para mundos maiores que a memória:
+//   cabeçalho | índice (mínimo e escala de cada tile) | tiles
+// Cada tile ocupa TileSize x TileSize alturas uint16 (os da borda são
+// completados), então o tile N começa em TileDataOffset + N * TileBytes. O
+// arquivo é mapeado em memória e o sistema só carrega as páginas lidas.
+class TESTES_API FTerrainHeightfieldFile
+{
+public:
+    FTerrainHeightfieldFile();
+    ~FTerrainHeightfieldFile();
+
+    // Grava o arquivo pedindo um tile por vez a FillTile (alturas da região,
+    // em ordem de linha), sem precisar do mapa inteiro na memória
+    static bool Write(const FString& Path, int32 NumX, int32 NumY, float CellSize, int32 TileSize, TFunctionRef<void(const FTerrainDirtyRegion&, TArray<float>&)> FillTile);
+    static bool Write(const FString& Path, const FTerrainHeightfield& Heightfield, int32 TileSize);
+
+    bool Open(const FString& Path);
+    void Close();
+    bool IsOpen() const { return MappedRegion != nullptr; }
+
+    int32 GetNumX() const { return NumX; }
+    int32 GetNumY() const { return NumY; }
+    float GetCellSize() const { return CellSize; }
+    int32 GetTileSize() const { return TileSize; }
+    int32 GetNumTilesX() const { return NumTilesX; }
+    int32 GetNumTilesY() const { return NumTilesY; }
+
+    // Vértices [Min, Max) do tile
+    FTerrainDirtyRegion GetTileRegion(int32 TileX, int32 TileY) const;
+
+    // Acesso aleatório: decodifica só o tile (ou o vértice) pedido
+    bool ReadTile(int32 TileX, int32 TileY, TArray<float>& OutHeights) const;
+    float GetHeight(int32 X, int32 Y) const;
+    bool ReadRegion(const FTerrainDirtyRegion& Region, TArray<float>& OutHeights) const;
+
+    // Carrega o arquivo inteiro num heightfield
+    bool ReadAll(FTerrainHeightfield& OutHeightfield) const;
+
+private:
+    struct FTileEntry
+    {
+        float MinHeight;
+        float Scale;
+    };
+
+    const FTileEntry& GetEntry(int32 TileX, int32 TileY) const { return Entries[TileY * NumTilesX + TileX]; }
+    const uint16* GetTileData(int32 TileX, int32 TileY) const;
+
+    TUniquePtr<IMappedFileHandle> MappedFile;
+    TUniquePtr<IMappedFileRegion> MappedRegion;
+
+    const FTileEntry* Entries = nullptr;
+    const uint8* TileData = nullptr;
+
+    int32 NumX = 0;
+    int32 NumY = 0;
+    float CellSize = 100.0f;
+    int32 TileSize = 0;
+    int32 NumTilesX = 0;
+    int32 NumTilesY = 0;
+};
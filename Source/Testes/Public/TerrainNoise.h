@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+
+// Parâmetros do fBm compartilhados pelos geradores de mapa
+struct TESTES_API FTerrainNoiseSettings
+{
+    float NoiseScale = 50.0f;
+    int32 Octaves = 4;
+    float Persistence = 0.5f;
+    float Lacunarity = 2.0f;
+    int32 Seed = 1337;
+};
+
+// Ruído Perlin fBm avaliado em lotes de 4 amostras (SIMD).
+// As tabelas de frequência/amplitude, a permutação e os deslocamentos das
+// oitavas (os dois últimos derivados de Seed) são montados uma vez no
+// construtor, então a mesma instância pode ser usada por várias threads.
+class TESTES_API FTerrainNoise
+{
+public:
+    explicit FTerrainNoise(const FTerrainNoiseSettings& InSettings);
+
+    // Avalia Count amostras da linha Y a partir de StartX. Resultado em [0,1].
+    void SampleRow(int32 StartX, int32 Y, int32 Count, float* OutValues) const;
+
+    // Avalia um bloco NumX x NumY (linha a linha em OutValues), dividido em
+    // faixas de linhas processadas em paralelo
+    void SampleGrid(int32 StartX, int32 StartY, int32 NumX, int32 NumY, float* OutValues) const;
+
+    // Como SampleRow/SampleGrid, mais as derivadas analíticas do resultado em
+    // X e Y (por unidade de amostra), sem amostras extras
+    void SampleRowWithDerivatives(int32 StartX, int32 Y, int32 Count, float* OutValues, float* OutDX, float* OutDY) const;
+    void SampleGridWithDerivatives(int32 StartX, int32 StartY, int32 NumX, int32 NumY, float* OutValues, float* OutDX, float* OutDY) const;
+
+    // Avalia uma única amostra (mesmo resultado de SampleRow)
+    float Sample(float X, float Y) const;
+
+    const FTerrainNoiseSettings& GetSettings() const { return Settings; }
+
+    // Oitavas além disso têm peso desprezível
+    static constexpr int32 MaxOctaves = 16;
+
+private:
+    // Versões do fBm com o tipo de ruído e a quantidade de oitavas fixos em
+    // tempo de compilação (FixedOctaves == 0 usa NumOctaves). O construtor
+    // escolhe uma vez qual delas SampleRow/Sample chamam. Com bDerivatives,
+    // OutDX/OutDY recebem as derivadas; sem, são ignorados.
+    template<typename KernelType, int32 FixedOctaves, bool bDerivatives>
+    void SampleRowImpl(int32 StartX, int32 Y, int32 Count, float* OutValues, float* OutDX, float* OutDY) const;
+
+    template<typename KernelType, int32 FixedOctaves, bool bDerivatives>
+    void SampleBlockImpl(const float* X, float Y, float* OutValues, float* OutDX, float* OutDY) const;
+
+    template<typename KernelType, int32 FixedOctaves>
+    void SelectKernel();
+
+    using FSampleRowFunc = void (FTerrainNoise::*)(int32, int32, int32, float*, float*, float*) const;
+    using FSampleBlockFunc = void (FTerrainNoise::*)(const float*, float, float*, float*, float*) const;
+
+    FSampleRowFunc SampleRowFunc = nullptr;
+    FSampleRowFunc SampleRowDerivativesFunc = nullptr;
+    FSampleBlockFunc SampleBlockFunc = nullptr;
+
+    FTerrainNoiseSettings Settings;
+    int32 NumOctaves = 0;
+
+    // Frequência de cada oitava já dividida por NoiseScale
+    float OctaveFrequencies[MaxOctaves];
+
+    // Peso de cada oitava já normalizado pela soma das amplitudes
+    float OctaveWeights[MaxOctaves];
+
+    // Deslocamento de cada oitava no espaço do ruído
+    float OctaveOffsetsX[MaxOctaves];
+    float OctaveOffsetsY[MaxOctaves];
+
+    TStaticArray<uint8, 512> Permutation;
+};
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+#include "TerrainNoise.h"
+
+// Contadores do cache de ruído
+struct TESTES_API FTerrainNoiseCacheStats
+{
+    int64 Hits = 0;
+    int64 Misses = 0;
+    int32 NumTiles = 0;
+    int32 MaxTiles = 0;
+    int64 NumBytes = 0;
+    int64 MaxBytes = 0;
+};
+
+// Cache LRU de tiles de ruído (valor + derivadas) compartilhado por todos os
+// geradores. A chave é a configuração do ruído mais a coordenada do tile, então
+// mudar propriedades que não afetam o ruído (materiais, meshes, altura) não
+// recalcula nada. Pode ser usado de qualquer thread.
+//
+// A capacidade cresce sozinha até caber o maior bloco pedido (senão cada
+// regeneração do mapa expulsaria os próprios tiles), mas nunca passa do
+// orçamento em bytes. Mapas maiores que o orçamento continuam corretos; só
+// deixam de ter acertos entre uma geração e outra.
+class TESTES_API FTerrainNoiseTileCache
+{
+public:
+    // Amostras por lado de cada tile
+    static constexpr int32 TileSize = 128;
+
+    // Memória de um tile: valor, dX e dY em float
+    static constexpr int64 TileBytes = 3 * TileSize * TileSize * sizeof(float);
+
+    // 256 MB: cerca de 1300 tiles, um mapa de ~4600 x 4600 vértices
+    static constexpr int64 DefaultMaxBytes = 256ll * 1024 * 1024;
+
+    static FTerrainNoiseTileCache& Get();
+
+    explicit FTerrainNoiseTileCache(int64 InMaxBytes = DefaultMaxBytes);
+
+    // Mesmo resultado de FTerrainNoise::SampleGridWithDerivatives; OutDX e
+    // OutDY podem ser nulos. Tiles ausentes são gerados em paralelo.
+    void SampleGrid(const FTerrainNoiseSettings& Settings, int32 StartX, int32 StartY, int32 NumX, int32 NumY, float* OutValues, float* OutDX = nullptr, float* OutDY = nullptr);
+
+    // Orçamento de memória dos tiles. Diminuir abaixo do tamanho atual
+    // esvazia o cache; o mínimo é um tile.
+    void SetMaxBytes(int64 InMaxBytes);
+
+    int64 GetMaxBytes() const;
+
+    void Empty();
+
+    FTerrainNoiseCacheStats GetStats() const;
+
+private:
+    // Cresce para MinTiles, limitado pelo orçamento. Crescer esvazia o LRU,
+    // então é feito antes de procurar os tiles. Chamar com Mutex travado.
+    void GrowToLocked(int32 MinTiles);
+
+    struct FTileKey
+    {
+        FTerrainNoiseSettings Settings;
+        FIntPoint Tile;
+
+        // Oitavas como FTerrainNoise as usa: valores além do limite geram o
+        // mesmo ruído e precisam da mesma chave
+        FTileKey(const FTerrainNoiseSettings& InSettings, const FIntPoint& InTile)
+            : Settings(InSettings)
+            , Tile(InTile)
+        {
+            Settings.Octaves = FMath::Clamp(Settings.Octaves, 0, FTerrainNoise::MaxOctaves);
+        }
+
+        bool operator==(const FTileKey& Other) const
+        {
+            return Tile == Other.Tile
+                && Settings.NoiseScale == Other.Settings.NoiseScale
+                && Settings.Octaves == Other.Settings.Octaves
+                && Settings.Persistence == Other.Settings.Persistence
+                && Settings.Lacunarity == Other.Settings.Lacunarity
+                && Settings.Seed == Other.Settings.Seed;
+        }
+
+        friend uint32 GetTypeHash(const FTileKey& Key)
+        {
+            uint32 Hash = GetTypeHash(Key.Tile);
+            Hash = HashCombine(Hash, GetTypeHash(Key.Settings.NoiseScale));
+            Hash = HashCombine(Hash, GetTypeHash(Key.Settings.Octaves));
+            Hash = HashCombine(Hash, GetTypeHash(Key.Settings.Persistence));
+            Hash = HashCombine(Hash, GetTypeHash(Key.Settings.Lacunarity));
+            return HashCombine(Hash, GetTypeHash(Key.Settings.Seed));
+        }
+    };
+
+    // TileSize x TileSize amostras de valor, dX e dY
+    struct FTile
+    {
+        TArray<float> Values;
+        TArray<float> DX;
+        TArray<float> DY;
+    };
+
+    mutable FCriticalSection Mutex;
+    TLruCache<FTileKey, TSharedPtr<const FTile>> Tiles;
+    int64 MaxBytes = DefaultMaxBytes;
+    int64 Hits = 0;
+    int64 Misses = 0;
+};
@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TerrainHeightfield.h"
+#include "TerrainQuantizedHeightfield.generated.h"
+
+// Erro introduzido pela quantização, medido contra as alturas recebidas por
+// Encode e pelas recodificações seguintes
+USTRUCT(BlueprintType)
+struct TESTES_API FTerrainQuantizationReport
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Terrain")
+    float MaxError = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Terrain")
+    float RmsError = 0.0f;
+
+    // Maior passo de quantização entre os chunks (amplitude do chunk / 65535)
+    UPROPERTY(BlueprintReadOnly, Category = "Terrain")
+    float MaxStep = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Terrain")
+    int64 QuantizedBytes = 0;
+
+    // O mesmo mapa guardado em float
+    UPROPERTY(BlueprintReadOnly, Category = "Terrain")
+    int64 FloatBytes = 0;
+};
+
+// Como DecodeWindow/EncodeWindow tratam os chunks da camada fria
+enum class ETerrainChunkAccess : uint8
+{
+    // Descomprime os chunks e marca o acesso (edições e leituras locais)
+    Resident,
+
+    // Passes no mapa inteiro: um chunk frio é lido de uma cópia temporária
+    // e recomprimido logo depois de escrito, e nada conta como acesso, então
+    // a camada fria continua como estava
+    Streaming
+};
+
+// Alturas guardadas como uint16, com mínimo e escala por chunk de
+// ChunkSize x ChunkSize vértices (altura = Min + Valor * Scale). Quem edita
+// decodifica só a janela que precisa e recodifica os chunks alterados.
+//
+// Cada chunk pode ainda ser comprimido (camada fria, ver
+// FTerrainChunkResidency); uma leitura ou escrita Resident o descomprime
+// antes, uma Streaming usa uma cópia temporária e o deixa comprimido.
+// Leituras podem vir de várias threads ao mesmo tempo; comprimir só a
+// partir de uma, sem leituras em andamento (ex.: game thread).
+class TESTES_API FTerrainQuantizedHeightfield
+{
+public:
+    FTerrainQuantizationReport Encode(const FTerrainHeightfield& Source, int32 InChunkSize);
+
+    // O mesmo sem o mapa inteiro na memória: ReadChunk preenche as alturas
+    // de cada chunk (região da grade, em ordem de linha), por exemplo de um
+    // FTerrainHeightfieldFile. Chamado de várias threads ao mesmo tempo.
+    FTerrainQuantizationReport Encode(int32 InNumX, int32 InNumY, float InCellSize, int32 InChunkSize, TFunctionRef<void(const FTerrainDirtyRegion&, TArray<float>&)> ReadChunk);
+    void Reset();
+
+    // Erro acumulado desde Encode (edições incluídas) e memória atual
+    FTerrainQuantizationReport GetReport() const;
+
+    bool IsEmpty() const { return Chunks.Num() == 0; }
+    int32 GetNumX() const { return NumX; }
+    int32 GetNumY() const { return NumY; }
+    float GetCellSize() const { return CellSize; }
+
+    FTerrainDirtyRegion GetFullRegion() const;
+
+    // Mesmas regras de FTerrainHeightfield::GetRegionInBox/GetRegionInRadius
+    FTerrainDirtyRegion GetRegionInBox(const FVector2D& BoxMin, const FVector2D& BoxMax) const;
+    FTerrainDirtyRegion GetRegionInRadius(const FVector2D& Center, float Radius) const;
+
+    float GetHeight(int32 X, int32 Y) const;
+
+    // Decodifica Region (recortada à grade) num heightfield próprio e
+    // devolve o canto da janela na grade
+    FIntPoint DecodeWindow(const FTerrainDirtyRegion& Region, FTerrainHeightfield& OutWindow, ETerrainChunkAccess Access = ETerrainChunkAccess::Resident) const;
+
+    // Recodifica os chunks que tocam Dirty (coordenadas da grade) com as
+    // alturas da janela decodificada em Origin. Um chunk cuja faixa de
+    // alturas continua cabendo no mínimo/escala atuais os mantém, então
+    // vértices fora da edição não mudam de valor.
+    void EncodeWindow(const FTerrainHeightfield& Window, const FIntPoint& Origin, const FTerrainDirtyRegion& Dirty, ETerrainChunkAccess Access = ETerrainChunkAccess::Resident);
+
+    int64 GetAllocatedSize() const;
+
+    // Camada fria (usada por FTerrainChunkResidency)
+    int32 GetNumChunks() const { return Chunks.Num(); }
+    FTerrainDirtyRegion GetChunkRegion(int32 ChunkIndex) const;
+    bool IsChunkResident(int32 ChunkIndex) const { return Chunks[ChunkIndex].Compressed.Num() == 0; }
+
+    // Relógio de acesso: cada chunk lido/escrito guarda o valor atual
+    uint32 GetAccessClock() const { return AccessClock; }
+    uint32 GetChunkLastAccess(int32 ChunkIndex) const { return Chunks[ChunkIndex].LastAccess; }
+    void AdvanceAccessClock() { ++AccessClock; }
+
+    // Comprime o chunk (delta + FCompression) e libera os valores; devolve
+    // os bytes economizados (0 se já estava comprimido ou não compensou)
+    int64 CompressChunk(int32 ChunkIndex);
+
+    int64 GetNumCompressions() const { return NumCompressions; }
+    int64 GetNumDecompressions() const { return NumDecompressions; }
+
+private:
+    struct FChunk
+    {
+        float MinHeight = 0.0f;
+        float Scale = 0.0f;
+        int32 Width = 0;
+        uint32 LastAccess = 0;
+
+        // Erro de quantização do chunk (limite superior depois de edições)
+        float MaxError = 0.0f;
+        double SumSquared = 0.0;
+
+        // Quente: Values; fria: Compressed (e Values vazio)
+        TArray<uint16> Values;
+        TArray<uint8> Compressed;
+    };
+
+    FORCEINLINE int32 GetChunkIndex(int32 X, int32 Y) const { return (Y / ChunkSize) * NumChunksX + X / ChunkSize; }
+
+    // Descomprime os chunks que tocam Region e marca o acesso
+    void MakeResident(const FTerrainDirtyRegion& Region) const;
+    void DecompressChunk(int32 ChunkIndex) const;
+
+    // Valores de um chunk sem mudar seu estado: os próprios se residente,
+    // senão descomprimidos em Scratch
+    const TArray<uint16>& GetChunkValues(int32 ChunkIndex, TArray<uint16>& Scratch) const;
+    void DecompressValues(int32 ChunkIndex, TArray<uint16>& OutValues) const;
+    bool CompressValues(const FChunk& Chunk, TArray<uint8>& OutCompressed) const;
+
+    // Quantiza Heights (ordem de linha do chunk), recalculando mínimo/escala
+    // só se a faixa nova não couber nos atuais, e atualiza o erro do chunk
+    void EncodeChunk(int32 ChunkIndex, const TArray<float>& Heights);
+
+    // Só para chunks residentes
+    FORCEINLINE float Decode(int32 X, int32 Y) const
+    {
+        const FChunk& Chunk = Chunks[GetChunkIndex(X, Y)];
+        return Chunk.MinHeight + Chunk.Values[(Y % ChunkSize) * Chunk.Width + X % ChunkSize] * Chunk.Scale;
+    }
+
+    // Mutável: ler um chunk frio o descomprime
+    mutable TArray<FChunk> Chunks;
+    mutable FCriticalSection ResidencyMutex;
+
+    // Só trocas de camada: a cópia temporária de Streaming não conta
+    mutable int64 NumDecompressions = 0;
+    int64 NumCompressions = 0;
+    uint32 AccessClock = 0;
+
+    int32 NumX = 0;
+    int32 NumY = 0;
+    float CellSize = 100.0f;
+    int32 ChunkSize = 64;
+    int32 NumChunksX = 0;
+    int32 NumChunksY = 0;
+};
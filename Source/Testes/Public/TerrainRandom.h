@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Finalidade de cada sorteio. Entra no hash para que decisões diferentes na
+// mesma célula (ex.: ter árvore e girar a árvore) não sejam correlacionadas.
+// Só acrescente valores no fim: mudar os existentes muda os mundos gerados.
+enum class ETerrainRandomPurpose : uint32
+{
+    TreePlacement = 1,
+    Droplet = 2,
+    NoiseOffset = 3,
+    NoisePermutation = 4,
+};
+
+// Números aleatórios por contador: o valor é um hash de (Seed, X, Y,
+// Purpose, Counter), sem estado compartilhado. Qualquer célula pode ser
+// avaliada sozinha, em qualquer ordem ou thread, com o mesmo resultado.
+struct FTerrainRandom
+{
+    static FORCEINLINE uint32 Mix(uint32 Value)
+    {
+        Value ^= Value >> 16;
+        Value *= 0x7FEB352Du;
+        Value ^= Value >> 15;
+        Value *= 0x846CA68Bu;
+        Value ^= Value >> 16;
+        return Value;
+    }
+
+    static FORCEINLINE uint32 Hash(int32 Seed, int32 X, int32 Y, ETerrainRandomPurpose Purpose, uint32 Counter = 0)
+    {
+        uint32 Result = Mix((uint32)Seed ^ 0x9E3779B9u);
+        Result = Mix(Result + (uint32)X * 0x85EBCA6Bu);
+        Result = Mix(Result + (uint32)Y * 0xC2B2AE35u);
+        Result = Mix(Result + (uint32)Purpose * 0x27D4EB2Fu);
+        return Mix(Result + Counter * 0x165667B1u);
+    }
+
+    // [0, 1)
+    static FORCEINLINE float FRand(int32 Seed, int32 X, int32 Y, ETerrainRandomPurpose Purpose, uint32 Counter = 0)
+    {
+        return (Hash(Seed, X, Y, Purpose, Counter) >> 8) * (1.0f / 16777216.0f);
+    }
+};
+
+// Sequência de sorteios de uma mesma chave (ex.: vários valores por célula
+// ou por gota). Cada chamada avança só o contador local.
+struct FTerrainRandomStream
+{
+    FTerrainRandomStream(int32 InSeed, int32 InX, int32 InY, ETerrainRandomPurpose InPurpose)
+        : Seed(InSeed), X(InX), Y(InY), Purpose(InPurpose)
+    {
+    }
+
+    FORCEINLINE uint32 GetUnsignedInt() { return FTerrainRandom::Hash(Seed, X, Y, Purpose, Counter++); }
+    FORCEINLINE float FRand() { return FTerrainRandom::FRand(Seed, X, Y, Purpose, Counter++); }
+    FORCEINLINE float FRandRange(float Min, float Max) { return Min + (Max - Min) * FRand(); }
+
+private:
+    int32 Seed;
+    int32 X;
+    int32 Y;
+    ETerrainRandomPurpose Purpose;
+    uint32 Counter = 0;
+};
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Segmento de um caminho de rio (espaço local do terreno)
+struct TESTES_API FTerrainRiverSegment
+{
+    FVector2D Start = FVector2D::ZeroVector;
+    FVector2D End = FVector2D::ZeroVector;
+    int32 PathIndex = INDEX_NONE;
+    int32 PointIndex = INDEX_NONE;
+};
+
+// Resultado de uma consulta de ponto mais próximo
+struct TESTES_API FTerrainRiverHit
+{
+    int32 SegmentIndex = INDEX_NONE;
+    FVector2D ClosestPoint = FVector2D::ZeroVector;
+    float Distance = FLT_MAX;
+
+    bool IsValid() const { return SegmentIndex != INDEX_NONE; }
+};
+
+// Rede de rios (principal + afluentes) com índice de grade uniforme sobre
+// os segmentos. As consultas são const e podem rodar em qualquer thread
+// enquanto a rede não for alterada.
+class TESTES_API FTerrainRiverNetwork
+{
+public:
+    explicit FTerrainRiverNetwork(float InCellSize = 1000.0f);
+
+    void Reset();
+
+    // Adiciona um caminho e reconstrói o índice. Devolve o índice do caminho.
+    int32 AddPath(const TArray<FVector2D>& Path);
+
+    const TArray<TArray<FVector2D>>& GetPaths() const { return Paths; }
+    const TArray<FTerrainRiverSegment>& GetSegments() const { return Segments; }
+    int32 NumPaths() const { return Paths.Num(); }
+
+    // Segmento mais próximo de Point (busca em anéis de células a partir de Point)
+    FTerrainRiverHit FindNearest(const FVector2D& Point) const;
+
+    // Distância até o rio mais próximo (FLT_MAX se a rede estiver vazia)
+    float GetDistanceToRiver(const FVector2D& Point) const;
+
+    // Índices dos segmentos a até Radius de Point
+    void FindSegmentsInRadius(const FVector2D& Point, float Radius, TArray<int32>& OutSegments) const;
+
+private:
+    void RebuildIndex();
+
+    FIntPoint GetCell(const FVector2D& Point) const;
+    void TestCell(int32 CellX, int32 CellY, const FVector2D& Point, FTerrainRiverHit& InOutHit) const;
+
+    float CellSize;
+
+    TArray<TArray<FVector2D>> Paths;
+    TArray<FTerrainRiverSegment> Segments;
+
+    // Grade densa sobre a caixa dos segmentos, em formato CSR:
+    // segmentos da célula i em CellSegments[CellStart[i] .. CellStart[i + 1])
+    FIntPoint GridOrigin = FIntPoint::ZeroValue;
+    int32 NumCellsX = 0;
+    int32 NumCellsY = 0;
+    TArray<int32> CellStart;
+    TArray<int32> CellSegments;
+};